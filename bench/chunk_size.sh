@@ -0,0 +1,60 @@
+#! /bin/bash
+
+# Measures the time of chunked upload for fixed chunk sizes and for sizes
+# picked by measured throughput, on a loopback TLS server, which models a
+# LAN path and a long WAN path by its processing delay and upload rate.
+# Every run uploads two files in one command, so the second file is split
+# by the measurements of the first one.
+# Requires node and openssl. To compare builds, set EXEC to the binary.
+# Usage: chunk_size.sh [size [chunk ...]], size is in 'head -c' format.
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+EXEC=${EXEC:-$DIR/../src/liquidfiles}
+
+SIZE=${1:-256M}
+shift
+CHUNKS=${@:-1M 8M 32M 100M auto}
+PARALLEL=${PARALLEL:-4}
+PORT=${PORT:-8443}
+SERVER=https://127.0.0.1:$PORT
+WORK=.tmp_bench
+
+# Profiles of path: name, delay of responce in ms, upload rate of request.
+PROFILES="lan:2:0 wan:80:4194304"
+
+function fail {
+    echo "Bench FAILED: $1"
+    kill $PID 2> /dev/null
+    exit 1
+}
+
+mkdir -p $WORK
+openssl req -x509 -newkey rsa:2048 -nodes -subj /CN=127.0.0.1 -days 1 \
+    -keyout $WORK/key.pem -out $WORK/cert.pem 2> /dev/null || fail "No openssl."
+head -c $SIZE /dev/urandom > $WORK/upload1
+cp $WORK/upload1 $WORK/upload2
+BYTES=`stat -c %s $WORK/upload1`
+
+printf "%8s %8s %10s %10s %10s\n" "Path" "Chunk" "Requests" "Time (s)" "MB/s"
+for profile in $PROFILES;
+do
+    IFS=: read name delay rate <<< "$profile"
+    DELAY=$delay RATE=$rate node $DIR/loopback_server.js $PORT $WORK/key.pem $WORK/cert.pem &
+    PID=$!
+    sleep 1
+    for chunk in $CHUNKS;
+    do
+        TIMEFORMAT="%R"
+        { time $EXEC attach --server=$SERVER -k --api_key=bench --report_level=verbose \
+            --parallel=$PARALLEL --chunk_size=$chunk $WORK/upload1 $WORK/upload2 \
+            > $WORK/output 2> /dev/null ; } 2> $WORK/time
+        test $? -eq 0 || fail "Upload by $chunk chunks failed."
+        read elapsed < $WORK/time
+        requests=`sed -n 's/^Requests: \([0-9]*\),.*/\1/p' $WORK/output`
+        awk -v p=$name -v c=$chunk -v r=$requests -v e=$elapsed -v n=$BYTES 'BEGIN {
+            printf "%8s %8s %10d %10.2f %10.1f\n", p, c, r, e, 2 * n / e / 1048576 }'
+    done
+    kill $PID
+    wait $PID 2> /dev/null
+done
+rm -rf $WORK
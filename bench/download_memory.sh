@@ -0,0 +1,30 @@
+#! /bin/bash
+
+# Measures peak resident memory of 'download' for files of growing size.
+# Peak RSS is expected to stay flat, as downloaded data is streamed to disk.
+# Usage: download_memory.sh [size ...], sizes are in 'truncate' format.
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+source $DIR/../test/common.sh
+
+SIZES=${@:-1M 10M 100M 1G 10G}
+WORK=.tmp_bench
+
+mkdir -p $WORK
+printf "%10s %14s %10s\n" "Size" "Max RSS (KB)" "Time (s)"
+for size in $SIZES;
+do
+    head -c $size /dev/urandom > $WORK/bench_$size
+    MESSAGE=`$EXEC send --to=xustup@example.com --server=$SERVER -k --api_key=$KEY --subject="Bench" $WORK/bench_$size`
+    test_status "Couldn't send file of size $size."
+    MESSAGE=${MESSAGE##* }
+    rm -f $WORK/bench_$size
+    mkdir -p $WORK/out
+    /usr/bin/time -f "%M %e" -o $WORK/time $EXEC download --server=$SERVER -k --api_key=$KEY \
+        --report_level=silent --message_id=$MESSAGE --download_to=$WORK/out
+    test_status "Couldn't download file of size $size."
+    read rss elapsed < $WORK/time
+    printf "%10s %14s %10s\n" $size $rss $elapsed
+    rm -rf $WORK/out
+done
+rm -rf $WORK
@@ -0,0 +1,81 @@
+// Microbenchmark of the hash kernels used to verify downloads.
+// Prints throughput of portable and PCLMUL CRC-32 and of SHA-256 for every
+// size given in bytes, and fails if CRC-32 kernels disagree.
+
+#include <lf/crc32.h>
+#include <lf/sha256.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <sys/time.h>
+
+namespace {
+
+double now()
+{
+    timeval t;
+    gettimeofday(&t, 0);
+    return t.tv_sec + t.tv_usec / 1e6;
+}
+
+// Count of repetitions to hash about 256MB of data.
+unsigned repetitions(size_t n)
+{
+    size_t r = (256u << 20) / (n == 0 ? 1 : n);
+    return r == 0 ? 1 : r;
+}
+
+double throughput(size_t n, unsigned r, double t)
+{
+    return t <= 0 ? 0 : n * static_cast<double>(r) / t / (1 << 20);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    bool pclmul = lf::crc32_pclmul_supported();
+    std::printf("%12s %16s %16s %16s\n", "Size", "CRC32 (MB/s)",
+            "CRC32 PCLMUL", "SHA-256 (MB/s)");
+    for (int a = 1; a < argc; ++a) {
+        size_t n = std::strtoul(argv[a], 0, 10);
+        std::vector<char> d(n + 1);
+        for (size_t i = 0; i < n; ++i) {
+            d[i] = static_cast<char>(std::rand());
+        }
+        unsigned r = repetitions(n);
+        uint32_t c1 = 0;
+        double t = now();
+        for (unsigned i = 0; i < r; ++i) {
+            c1 = lf::crc32_update_portable(0, &d[0], n);
+        }
+        double portable = throughput(n, r, now() - t);
+        double fast = 0;
+        if (pclmul) {
+            uint32_t c2 = 0;
+            t = now();
+            for (unsigned i = 0; i < r; ++i) {
+                c2 = lf::crc32_update_pclmul(0, &d[0], n);
+            }
+            fast = throughput(n, r, now() - t);
+            if (c1 != c2) {
+                std::printf("CRC32 mismatch for size %lu: %08x != %08x\n",
+                        static_cast<unsigned long>(n), c1, c2);
+                return 1;
+            }
+        }
+        lf::sha256 s;
+        t = now();
+        for (unsigned i = 0; i < r; ++i) {
+            s.reset();
+            s.update(&d[0], n);
+        }
+        s.hex_digest();
+        double sha = throughput(n, r, now() - t);
+        std::printf("%12lu %16.1f %16.1f %16.1f\n",
+                static_cast<unsigned long>(n), portable, fast, sha);
+    }
+    return 0;
+}
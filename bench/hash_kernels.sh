@@ -0,0 +1,19 @@
+#! /bin/bash
+
+# Measures throughput of the hash kernels, which verify downloaded files.
+# Sizes start from the size of test/large_file and grow to large files.
+# Usage: hash_kernels.sh [size ...], sizes are in bytes.
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+SRC=$DIR/../src
+
+SIZES=${@:-`stat -c %s $DIR/../test/large_file` 4096 65536 1048576 16777216 268435456}
+WORK=.tmp_bench
+
+mkdir -p $WORK
+${CXX:-g++} -O2 -I $SRC -o $WORK/hash_kernels $DIR/hash_kernels.cpp \
+    $SRC/lf/crc32.cpp $SRC/lf/sha256.cpp || exit 1
+$WORK/hash_kernels $SIZES
+status=$?
+rm -rf $WORK
+exit $status
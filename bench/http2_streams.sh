@@ -0,0 +1,62 @@
+#! /bin/bash
+
+# Compares HTTP/2 multiplexing with HTTP/1.1 connections for simultaneous
+# uploads and downloads of small files against a loopback TLS server.
+# Opened connections are counted from the timings of requests.
+# Requires node and openssl. To compare builds, set EXEC to the binary.
+# Usage: http2_streams.sh [streams ...]
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+EXEC=${EXEC:-$DIR/../src/liquidfiles}
+
+STREAMS=${@:-1 8 64}
+PORT=${PORT:-8443}
+SERVER=https://127.0.0.1:$PORT
+WORK=.tmp_bench
+
+function fail {
+    echo "Bench FAILED: $1"
+    kill $PID 2> /dev/null
+    exit 1
+}
+
+mkdir -p $WORK
+openssl req -x509 -newkey rsa:2048 -nodes -subj /CN=127.0.0.1 -days 1 \
+    -keyout $WORK/key.pem -out $WORK/cert.pem 2> /dev/null || fail "No openssl."
+node $DIR/loopback_server.js $PORT $WORK/key.pem $WORK/cert.pem &
+PID=$!
+sleep 1
+
+printf "%8s %8s %10s %12s %12s %12s\n" "HTTP" "Streams" "Operation" "Time (s)" "Requests/s" "Connections"
+for n in $STREAMS;
+do
+    rm -rf $WORK/files $WORK/out
+    mkdir -p $WORK/files $WORK/out
+    urls=""
+    for i in `seq $n`; do
+        head -c 16384 /dev/urandom > $WORK/files/f$i
+        urls="$urls $SERVER/download/f$i"
+    done
+    for http in 1.1 2;
+    do
+        for op in attach download;
+        do
+            rm -f $WORK/timings.csv $WORK/out/*
+            if [ $op == attach ]; then
+                args="attach --parallel=$n --chunk_size=0 $WORK/files/*"
+            else
+                args="download --parallel=$n --download_to=$WORK/out $urls"
+            fi
+            TIMEFORMAT="%R"
+            { time $EXEC $args --server=$SERVER -k --api_key=bench --report_level=silent \
+                --http=$http --timings=$WORK/timings.csv > /dev/null ; } 2> $WORK/time
+            test $? -eq 0 || fail "$op over HTTP/$http failed."
+            read elapsed < $WORK/time
+            connections=`tail -n +2 $WORK/timings.csv | cut -d, -f6 | grep -c 0`
+            awk -v h=$http -v n=$n -v o=$op -v e=$elapsed -v c=$connections 'BEGIN {
+                printf "%8s %8d %10s %12.3f %12.1f %12d\n", h, n, o, e, n / e, c }'
+        done
+    done
+done
+kill $PID
+rm -rf $WORK
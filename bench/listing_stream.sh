@@ -0,0 +1,52 @@
+#! /bin/bash
+
+# Measures the time to the first printed row and peak resident memory of
+# 'messages' and 'filelinks' for listings of growing size, which are sent
+# by a loopback TLS server in parts. As listings are parsed while they come,
+# the first row is expected right after the first part, and peak RSS is
+# expected to stay flat.
+# Requires node and openssl. To compare builds, set EXEC to the binary.
+# Usage: listing_stream.sh [records ...]
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+EXEC=${EXEC:-$DIR/../src/liquidfiles}
+
+COUNTS=${@:-1000 10000 100000 1000000}
+PORT=${PORT:-8443}
+SERVER=https://127.0.0.1:$PORT
+WORK=.tmp_bench
+
+function fail {
+    echo "Bench FAILED: $1"
+    kill $PID 2> /dev/null
+    exit 1
+}
+
+mkdir -p $WORK
+openssl req -x509 -newkey rsa:2048 -nodes -subj /CN=127.0.0.1 -days 1 \
+    -keyout $WORK/key.pem -out $WORK/cert.pem 2> /dev/null || fail "No openssl."
+
+printf "%10s %10s %16s %12s %14s\n" "Command" "Records" "First row (s)" "Time (s)" "Max RSS (KB)"
+for n in $COUNTS;
+do
+    RECORDS=$n DELAY=0 node $DIR/loopback_server.js $PORT $WORK/key.pem $WORK/cert.pem &
+    PID=$!
+    sleep 1
+    for command in messages filelinks;
+    do
+        start=`date +%s.%N`
+        /usr/bin/time -f "%M %e" -o $WORK/time $EXEC $command --server=$SERVER -k \
+            --api_key=bench --report_level=silent | {
+                read -r line && date +%s.%N > $WORK/first
+                cat > /dev/null
+            }
+        test ${PIPESTATUS[0]} -eq 0 || fail "$command of $n records failed."
+        read first < $WORK/first
+        read rss elapsed < $WORK/time
+        awk -v c=$command -v n=$n -v f=$first -v s=$start -v e=$elapsed -v r=$rss 'BEGIN {
+            printf "%10s %10d %16.3f %12.3f %14d\n", c, n, f - s, e, r }'
+    done
+    kill $PID
+    wait $PID 2> /dev/null
+done
+rm -rf $WORK
@@ -0,0 +1,93 @@
+// Loopback server for benchmarks, speaks HTTP/2 and HTTP/1.1 over TLS.
+// Uploads to /attachments are read and answered by an attachment ID, other
+// POST and DELETE requests are answered by empty body, listings of /message
+// and /link by RECORDS records sent in parts, other GET requests by SIZE
+// bytes. Every response is delayed by DELAY milliseconds, to model the
+// processing time of server, and every upload is read at RATE bytes per
+// second at most, to model the throughput of a long path, 0 is unlimited.
+// Chunks of file, but the last one, are answered by a space.
+// Usage: node loopback_server.js <port> <key> <cert>
+
+var fs = require('fs');
+var http2 = require('http2');
+
+var port = parseInt(process.argv[2], 10);
+var size = parseInt(process.env.SIZE || '16384', 10);
+var delay = parseInt(process.env.DELAY || '20', 10);
+var records = parseInt(process.env.RECORDS || '1000', 10);
+var rate = parseInt(process.env.RATE || '0', 10);
+var body = Buffer.alloc(size, 'x');
+var id = 0;
+
+function record(url, i) {
+    var n = ('0000000000000000000000' + i).slice(-22);
+    if (url.indexOf('/link') === 0) {
+        return '<link><id>' + n + '</id><filename>file' + i + '.bin</filename>' +
+            '<url>https://127.0.0.1/link/' + n + '</url>' +
+            '<expires_at>2030-01-01T00:00:00Z</expires_at><size>' + i + '</size></link>';
+    }
+    return '<message><id>' + n + '</id><sender>bench@example.com</sender>' +
+        '<recipients type="array"><recipient>user@example.com</recipient></recipients>' +
+        '<created_at>2030-01-01T00:00:00Z</created_at><expires_at>2030-02-01T00:00:00Z</expires_at>' +
+        '<authorization>3</authorization><subject>Bench ' + i + '</subject></message>';
+}
+
+function list(req, res) {
+    var root = req.url.indexOf('/link') === 0 ? 'links' : 'messages';
+    var i = 0;
+    res.writeHead(200, { 'Content-Type': 'text/xml' });
+    res.write('<?xml version="1.0" encoding="UTF-8"?>\n<' + root + ' type="array">');
+    (function part() {
+        var s = '';
+        for (var k = 0; k < 1000 && i < records; ++k) {
+            s += record(req.url, ++i);
+        }
+        if (i < records) {
+            res.write(s, function () { setImmediate(part); });
+        } else {
+            res.end(s + '</' + root + '>');
+        }
+    })();
+}
+
+var server = http2.createSecureServer({
+    key: fs.readFileSync(process.argv[3]),
+    cert: fs.readFileSync(process.argv[4]),
+    allowHTTP1: true
+}, function (req, res) {
+    var start = Date.now();
+    var received = 0;
+    var tail = '';
+    req.on('data', function (d) {
+        received += d.length;
+        tail = (tail + d.toString('latin1', Math.max(0, d.length - 512))).slice(-512);
+        var wait = rate > 0 ? received * 1000 / rate - (Date.now() - start) : 0;
+        if (wait > 0) {
+            req.pause();
+            setTimeout(function () { req.resume(); }, wait);
+        }
+    });
+    req.on('end', function () {
+        var chunk = /name="chunk"\r\n\r\n(\d+)/.exec(tail);
+        var chunks = /name="chunks"\r\n\r\n(\d+)/.exec(tail);
+        setTimeout(function () {
+            if (req.method === 'GET' && /^\/(message|link)(\?|$)/.test(req.url)) {
+                list(req, res);
+            } else if (req.method === 'GET') {
+                res.writeHead(200, { 'Content-Type': 'application/octet-stream',
+                    'Content-Length': size });
+                res.end(body);
+            } else if (req.url === '/attachments' && chunk && chunk[1] !== chunks[1]) {
+                res.writeHead(200, { 'Content-Type': 'text/plain' });
+                res.end(' ');
+            } else if (req.url === '/attachments') {
+                res.writeHead(200, { 'Content-Type': 'text/plain' });
+                res.end(('0000000000000000000000' + (++id)).slice(-22));
+            } else {
+                res.writeHead(200, { 'Content-Type': 'text/plain' });
+                res.end();
+            }
+        }, delay);
+    });
+});
+server.listen(port, '127.0.0.1');
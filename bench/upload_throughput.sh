@@ -0,0 +1,31 @@
+#! /bin/bash
+
+# Measures upload throughput and client CPU time per GB for several sizes of
+# upload buffer. To compare builds, set EXEC to the binary to measure.
+# Usage: upload_throughput.sh [size [buffer ...]], size is in 'head -c' format.
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+CUSTOM_EXEC=$EXEC
+source $DIR/../test/common.sh
+EXEC=${CUSTOM_EXEC:-$EXEC}
+
+SIZE=${1:-1G}
+shift
+BUFFERS=${@:-16K 64K 1M 2M}
+WORK=.tmp_bench
+
+mkdir -p $WORK
+head -c $SIZE /dev/urandom > $WORK/upload
+BYTES=`stat -c %s $WORK/upload`
+printf "%10s %10s %10s %14s\n" "Buffer" "Time (s)" "MB/s" "CPU (s) / GB"
+for buffer in $BUFFERS;
+do
+    TIMEFORMAT="%R %U %S"
+    { time $EXEC attach --server=$SERVER -k --api_key=$KEY --report_level=silent \
+        --chunk_size=0 --upload_buffer=$buffer $WORK/upload > /dev/null ; } 2> $WORK/time
+    test_status "Couldn't upload file with buffer $buffer."
+    read elapsed user sys < $WORK/time
+    awk -v b=$buffer -v e=$elapsed -v u=$user -v s=$sys -v n=$BYTES 'BEGIN {
+        printf "%10s %10.2f %10.1f %14.2f\n", b, e, n / e / 1048576, (u + s) * 1073741824 / n }'
+done
+rm -rf $WORK
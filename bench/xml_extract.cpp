@@ -0,0 +1,97 @@
+// Microbenchmark of getting one field of single value responces.
+// Prints the time per responce of a document parse with a walk over the
+// children of root, as the responces were read before, and of the scan by
+// xml::extract, and fails if they get different values.
+
+#include <xml/xml.h>
+#include <xml/xml_extract.h>
+#include <xml/xml_iterators.h>
+
+#include <cstdio>
+#include <string>
+
+#include <sys/time.h>
+
+namespace {
+
+const unsigned s_repetitions = 1000000;
+
+double now()
+{
+    timeval t;
+    gettimeofday(&t, 0);
+    return t.tv_sec + t.tv_usec / 1e6;
+}
+
+std::string walk(const std::string& r, const std::string& name)
+{
+    xml::document<> d;
+    d.parse<xml::parse_fastest | xml::parse_no_utf8>(const_cast<char*>(r.c_str()));
+    xml::node_iterator<> i(d.first_node());
+    xml::node_iterator<> e;
+    for (; i != e; ++i) {
+        std::string n(i->name(), i->name_size());
+        if (n == name) {
+            return std::string(i->value(), i->value_size());
+        }
+    }
+    return "";
+}
+
+template <typename Field>
+std::string extract(const std::string& r)
+{
+    const char* v = 0;
+    std::size_t n = 0;
+    xml::extract<Field>(r.c_str(), v, n);
+    return std::string(v == 0 ? "" : v, n);
+}
+
+template <typename Field>
+bool run(const char* title, const std::string& r, const std::string& name)
+{
+    std::string a;
+    double t = now();
+    for (unsigned i = 0; i < s_repetitions; ++i) {
+        a = walk(r, name);
+    }
+    double dom = (now() - t) / s_repetitions * 1e9;
+    std::string b;
+    t = now();
+    for (unsigned i = 0; i < s_repetitions; ++i) {
+        b = extract<Field>(r);
+    }
+    double scan = (now() - t) / s_repetitions * 1e9;
+    if (a != b) {
+        std::printf("%s: '%s' != '%s'\n", title, a.c_str(), b.c_str());
+        return false;
+    }
+    std::printf("%16s %16.1f %16.1f\n", title, dom, scan);
+    return true;
+}
+
+}
+
+int main()
+{
+    std::printf("%16s %16s %16s\n", "Responce", "Document (ns)", "Extract (ns)");
+    bool ok = run<xml::tag<'i', 'd'> >("send",
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<message>\n"
+            "  <id>fGmaEnCcvbxwa2SYtCTJVn</id>\n"
+            "  <sender>sender@example.com</sender>\n"
+            "  <subject>Report</subject>\n</message>\n", "id")
+        && run<xml::tag<'u', 'r', 'l'> >("create_filelink",
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<link>\n"
+            "  <id>aB3dE5fG7hJ9kL1mN3pQ5r</id>\n"
+            "  <filename>report.pdf</filename>\n"
+            "  <size>1048576</size>\n"
+            "  <expires_at>2026-11-18</expires_at>\n"
+            "  <url>https://example.com/link/aB3dE5fG7hJ9kL1mN3pQ5r</url>\n</link>\n", "url")
+        && run<xml::tag<'a', 'p', 'i', '_', 'k', 'e', 'y'> >("get_api_key",
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<user>\n"
+            "  <api_key>s5nhNBEBUxGmlbZ6ZrIE8RijeVlfZNcU</api_key>\n</user>\n", "api_key")
+        && run<xml::tag<'m', 'e', 's', 's', 'a', 'g', 'e'> >("error",
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<error>\n"
+            "  <message>Invalid API key</message>\n</error>\n", "message");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,17 @@
+#! /bin/bash
+
+# Measures the time to get the field of single value responces by a
+# document parse and by a scan without document.
+# Usage: xml_extract.sh
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+SRC=$DIR/../src
+
+WORK=.tmp_bench
+
+mkdir -p $WORK
+${CXX:-g++} -O2 -I $SRC -o $WORK/xml_extract $DIR/xml_extract.cpp || exit 1
+$WORK/xml_extract
+status=$?
+rm -rf $WORK
+exit $status
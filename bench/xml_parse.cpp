@@ -0,0 +1,140 @@
+// Microbenchmark of the xml parser on synthetic 'messages' listings.
+// Prints throughput of a whole document parse and of a stream parse for
+// scalar, SSE2 and AVX2 scan kernels and every count of messages given,
+// and fails if kernels do not read the same elements.
+
+#include <xml/xml_stream.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <sys/time.h>
+
+namespace {
+
+double now()
+{
+    timeval t;
+    gettimeofday(&t, 0);
+    return t.tv_sec + t.tv_usec / 1e6;
+}
+
+std::string number(unsigned long n)
+{
+    char b[32];
+    std::snprintf(b, sizeof(b), "%lu", n);
+    return b;
+}
+
+// Listing in the format of server, with indentation and long texts.
+std::string document(unsigned long n)
+{
+    std::string d = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<messages type=\"array\">\n";
+    for (unsigned long i = 0; i < n; ++i) {
+        std::string id = number(i);
+        d += "  <message>\n"
+            "    <id>m" + id + "</id>\n"
+            "    <sender>sender" + id + "@example.com</sender>\n"
+            "    <recipients type=\"array\">\n"
+            "      <recipient>first" + id + "@example.com</recipient>\n"
+            "      <recipient>second" + id + "@example.com</recipient>\n"
+            "    </recipients>\n"
+            "    <created_at>2026-10-18T10:00:00+00:00</created_at>\n"
+            "    <expires_at>2026-11-18T10:00:00+00:00</expires_at>\n"
+            "    <authorization>2</authorization>\n"
+            "    <authorization_description>Recipients need to authenticate</authorization_description>\n"
+            "    <subject>Quarterly report " + id + "</subject>\n"
+            "    <message>Hello, please find the quarterly report and the spreadsheets "
+            "attached. The numbers for the last month are not final yet, so the totals "
+            "may change slightly before the review meeting next week.</message>\n"
+            "    <attachments type=\"array\">\n"
+            "      <attachment>\n"
+            "        <filename>report-" + id + ".pdf</filename>\n"
+            "        <size>1048576</size>\n"
+            "        <checksum>9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08</checksum>\n"
+            "      </attachment>\n"
+            "    </attachments>\n"
+            "  </message>\n";
+    }
+    return d + "</messages>\n";
+}
+
+unsigned long count(xml::node<>* n)
+{
+    unsigned long c = 1;
+    for (xml::node<>* i = n->first_node(); i != 0; i = i->next_sibling()) {
+        c += count(i);
+    }
+    return c;
+}
+
+class counter : public xml::element_handler
+{
+public:
+    counter()
+        : m_count(0)
+    {
+    }
+
+    virtual void element(xml::node<>* n)
+    {
+        m_count += count(n);
+    }
+
+    unsigned long m_count;
+};
+
+const char* s_names[] = { "scalar", "SSE2", "AVX2" };
+
+}
+
+int main(int argc, char** argv)
+{
+    std::printf("%10s %8s %10s %18s %18s\n", "Messages", "Kernel", "Size (MB)",
+            "Document (MB/s)", "Stream (MB/s)");
+    for (int a = 1; a < argc; ++a) {
+        unsigned long n = std::strtoul(argv[a], 0, 10);
+        std::string d = document(n);
+        double mb = d.size() / 1048576.0;
+        unsigned r = 1 + static_cast<unsigned>(256 / mb);
+        unsigned long expected = 0;
+        for (int k = xml::scan::kernel_scalar; k <= xml::scan::kernel_avx2; ++k) {
+            xml::scan::kernel kernel = static_cast<xml::scan::kernel>(k);
+            if (!xml::scan::supported(kernel)) {
+                continue;
+            }
+            xml::scan::use(kernel);
+            unsigned long nodes = 0;
+            double t = now();
+            for (unsigned i = 0; i < r; ++i) {
+                xml::document<> x;
+                x.parse<xml::parse_fastest | xml::parse_no_utf8>(&d[0]);
+                nodes = count(x.first_node("messages"));
+            }
+            double whole = r * mb / (now() - t);
+            counter c;
+            xml::stream_parser p("message", c);
+            t = now();
+            for (unsigned i = 0; i < r; ++i) {
+                p.reset();
+                c.m_count = 0;
+                for (std::string::size_type o = 0; o < d.size(); o += 16384) {
+                    p.feed(d.data() + o, std::min<std::string::size_type>(16384, d.size() - o));
+                }
+                p.finish();
+            }
+            double stream = r * mb / (now() - t);
+            if (expected == 0) {
+                expected = nodes;
+            }
+            if (nodes != expected || c.m_count + 1 != expected) {
+                std::printf("Kernel %s read %lu and %lu elements, expected %lu\n",
+                        s_names[k], nodes, c.m_count + 1, expected);
+                return 1;
+            }
+            std::printf("%10lu %8s %10.1f %18.1f %18.1f\n", n, s_names[k], mb, whole, stream);
+        }
+    }
+    return 0;
+}
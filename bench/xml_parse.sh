@@ -0,0 +1,18 @@
+#! /bin/bash
+
+# Measures throughput of the xml parser with every scan kernel, which the
+# processor supports, on synthetic 'messages' listings.
+# Usage: xml_parse.sh [messages ...]
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+SRC=$DIR/../src
+
+COUNTS=${@:-10000 100000}
+WORK=.tmp_bench
+
+mkdir -p $WORK
+${CXX:-g++} -O2 -I $SRC -o $WORK/xml_parse $DIR/xml_parse.cpp || exit 1
+$WORK/xml_parse $COUNTS
+status=$?
+rm -rf $WORK
+exit $status
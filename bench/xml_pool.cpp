@@ -0,0 +1,112 @@
+// Microbenchmark of the memory pool of xml documents.
+// Parses responces of growing size many times by a new document for every
+// parse and by one document, which is reset between parses. Prints heap
+// allocations and time per parse.
+
+#include <xml/xml.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include <sys/time.h>
+
+namespace {
+
+unsigned long s_allocations = 0;
+
+double now()
+{
+    timeval t;
+    gettimeofday(&t, 0);
+    return t.tv_sec + t.tv_usec / 1e6;
+}
+
+// Message responce with the given count of attachments.
+std::string document(unsigned long n)
+{
+    std::string d = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<message>\n"
+        "  <id>fGmaEnCcvbxwa2SYtCTJVn</id>\n"
+        "  <sender>sender@example.com</sender>\n"
+        "  <subject>Report</subject>\n"
+        "  <attachments type=\"array\">\n";
+    for (unsigned long i = 0; i < n; ++i) {
+        char b[32];
+        std::snprintf(b, sizeof(b), "%lu", i);
+        d += std::string("    <attachment>\n"
+            "      <filename>file-") + b + ".pdf</filename>\n"
+            "      <size>1048576</size>\n"
+            "      <url>https://example.com/message/fGmaEnCcvbxwa2SYtCTJVn/download/" + b + "</url>\n"
+            "      <checksum>9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08</checksum>\n"
+            "    </attachment>\n";
+    }
+    return d + "  </attachments>\n</message>\n";
+}
+
+void parse(xml::document<>& d, std::string& r)
+{
+    d.parse<xml::parse_fastest | xml::parse_no_utf8>(&r[0]);
+}
+
+void report(unsigned long n, const char* mode, unsigned long a, double t, unsigned r)
+{
+    std::printf("%12lu %10s %18.1f %16.1f\n", n, mode,
+            static_cast<double>(a) / r, t / r * 1e6);
+}
+
+}
+
+void* operator new(std::size_t n) throw(std::bad_alloc)
+{
+    ++s_allocations;
+    void* p = std::malloc(n == 0 ? 1 : n);
+    if (p == 0) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](std::size_t n) throw(std::bad_alloc)
+{
+    return operator new(n);
+}
+
+void operator delete(void* p) throw()
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+    std::free(p);
+}
+
+int main(int argc, char** argv)
+{
+    std::printf("%12s %10s %18s %16s\n", "Attachments", "Document",
+            "Allocations/parse", "Time/parse (us)");
+    for (int a = 1; a < argc; ++a) {
+        unsigned long n = std::strtoul(argv[a], 0, 10);
+        std::string r = document(n);
+        unsigned k = 1 + static_cast<unsigned>((64u << 20) / r.size());
+        s_allocations = 0;
+        double t = now();
+        for (unsigned i = 0; i < k; ++i) {
+            xml::document<>* d = new xml::document<>;
+            parse(*d, r);
+            delete d;
+        }
+        report(n, "new", s_allocations - k, now() - t, k);
+        xml::document<>* d = new xml::document<>;
+        s_allocations = 0;
+        t = now();
+        for (unsigned i = 0; i < k; ++i) {
+            d->reset();
+            parse(*d, r);
+        }
+        report(n, "reset", s_allocations, now() - t, k);
+        delete d;
+    }
+    return 0;
+}
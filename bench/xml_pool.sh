@@ -0,0 +1,18 @@
+#! /bin/bash
+
+# Measures heap allocations and time per parse of xml responces, with a new
+# document for every parse and with a document reused between parses.
+# Usage: xml_pool.sh [attachments ...]
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+SRC=$DIR/../src
+
+COUNTS=${@:-10 1000 10000 100000}
+WORK=.tmp_bench
+
+mkdir -p $WORK
+${CXX:-g++} -std=c++98 -O2 -I $SRC -o $WORK/xml_pool $DIR/xml_pool.cpp || exit 1
+$WORK/xml_pool $COUNTS
+status=$?
+rm -rf $WORK
+exit $status
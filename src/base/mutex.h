@@ -0,0 +1,116 @@
+#pragma once
+
+#include <pthread.h>
+
+namespace base {
+
+/**
+ * @class mutex
+ * @brief Simple wrapper of pthread mutex.
+ */
+class mutex
+{
+public:
+    mutex()
+    {
+        pthread_mutex_init(&m_mutex, 0);
+    }
+
+    ~mutex()
+    {
+        pthread_mutex_destroy(&m_mutex);
+    }
+
+private:
+    mutex(const mutex&);
+    mutex& operator=(const mutex&);
+
+public:
+    void lock()
+    {
+        pthread_mutex_lock(&m_mutex);
+    }
+
+    void unlock()
+    {
+        pthread_mutex_unlock(&m_mutex);
+    }
+
+    pthread_mutex_t* native()
+    {
+        return &m_mutex;
+    }
+
+private:
+    pthread_mutex_t m_mutex;
+};
+
+/**
+ * @class scoped_lock
+ * @brief Locks the given mutex for the lifetime of object.
+ */
+class scoped_lock
+{
+public:
+    scoped_lock(mutex& m)
+        : m_mutex(m)
+    {
+        m_mutex.lock();
+    }
+
+    ~scoped_lock()
+    {
+        m_mutex.unlock();
+    }
+
+private:
+    scoped_lock(const scoped_lock&);
+    scoped_lock& operator=(const scoped_lock&);
+
+private:
+    mutex& m_mutex;
+};
+
+/**
+ * @class condition
+ * @brief Simple wrapper of pthread condition variable.
+ */
+class condition
+{
+public:
+    condition()
+    {
+        pthread_cond_init(&m_condition, 0);
+    }
+
+    ~condition()
+    {
+        pthread_cond_destroy(&m_condition);
+    }
+
+private:
+    condition(const condition&);
+    condition& operator=(const condition&);
+
+public:
+    /// @brief Waits for signal, the given mutex should be locked.
+    void wait(mutex& m)
+    {
+        pthread_cond_wait(&m_condition, m.native());
+    }
+
+    void signal()
+    {
+        pthread_cond_signal(&m_condition);
+    }
+
+    void broadcast()
+    {
+        pthread_cond_broadcast(&m_condition);
+    }
+
+private:
+    pthread_cond_t m_condition;
+};
+
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <pthread.h>
+
+namespace base {
+
+/**
+ * @class thread
+ * @brief Simple wrapper of pthread, runs the virtual function run.
+ */
+class thread
+{
+public:
+    thread()
+        : m_started(false)
+    {
+    }
+
+    virtual ~thread()
+    {
+        join();
+    }
+
+private:
+    thread(const thread&);
+    thread& operator=(const thread&);
+
+public:
+    /// @brief Starts the thread, returns false if it is not created.
+    bool start()
+    {
+        m_started = pthread_create(&m_thread, 0, &thread::entry, this) == 0;
+        return m_started;
+    }
+
+    /// @brief Waits for the end of thread.
+    void join()
+    {
+        if (m_started) {
+            pthread_join(m_thread, 0);
+            m_started = false;
+        }
+    }
+
+protected:
+    /// @brief Body of thread.
+    virtual void run() = 0;
+
+private:
+    static void* entry(void* p)
+    {
+        static_cast<thread*>(p)->run();
+        return 0;
+    }
+
+private:
+    pthread_t m_thread;
+    bool m_started;
+};
+
+/**
+ * @class thread_specific
+ * @brief Object of type T, which is separate for every thread.
+ *
+ *        Object is default constructed when the thread accesses it first
+ *        time, and is deleted when the thread exits.
+ */
+template <typename T>
+class thread_specific
+{
+public:
+    thread_specific()
+    {
+        pthread_key_create(&m_key, &thread_specific::destroy);
+    }
+
+    /// @brief Deletes the object of calling thread and frees the key.
+    ~thread_specific()
+    {
+        destroy(pthread_getspecific(m_key));
+        pthread_key_delete(m_key);
+    }
+
+private:
+    thread_specific(const thread_specific&);
+    thread_specific& operator=(const thread_specific&);
+
+public:
+    /// @brief Access to the object of calling thread.
+    T& get()
+    {
+        T* t = static_cast<T*>(pthread_getspecific(m_key));
+        if (t == 0) {
+            t = new T();
+            pthread_setspecific(m_key, t);
+        }
+        return *t;
+    }
+
+private:
+    static void destroy(void* p)
+    {
+        delete static_cast<T*>(p);
+    }
+
+private:
+    pthread_key_t m_key;
+};
+
+}
@@ -28,4 +28,10 @@ inline int string_to_val<int>(const std::string& v)
     return base::from_string<int>(v);
 }
 
+template <>
+inline std::string val_to_string<int>(const int& v)
+{
+    return base::to_string(v);
+}
+
 }
@@ -23,6 +23,11 @@ const std::set<std::string>& arguments::get_unnamed_arguments() const
     return m_unnamed_arguments;
 }
 
+const std::vector<std::string>& arguments::get_unnamed_argument_list() const
+{
+    return m_unnamed_argument_list;
+}
+
 const std::set<std::string>& arguments::get_boolean_arguments() const
 {
     return m_boolean_arguments;
@@ -48,6 +53,7 @@ arguments arguments::construct(const std::vector<std::string>& str)
             args.m_boolean_arguments.insert(*i);
         } else {
             args.m_unnamed_arguments.insert(*i);
+            args.m_unnamed_argument_list.push_back(*i);
         }
         ++i;
     }
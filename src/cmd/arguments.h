@@ -26,6 +26,10 @@ public:
     /// @brief Access to unnamed arguments.
     const std::set<std::string>& get_unnamed_arguments() const;
 
+    /// @brief Access to unnamed arguments in the given order, repeated ones
+    ///        included.
+    const std::vector<std::string>& get_unnamed_argument_list() const;
+
     /// @brief Access to boolean arguments.
     const std::set<std::string>& get_boolean_arguments() const;
 
@@ -38,6 +42,7 @@ public:
 
 private:
     std::set<std::string> m_unnamed_arguments;
+    std::vector<std::string> m_unnamed_argument_list;
     std::set<std::string> m_boolean_arguments;
 };
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <base/exception.h>
+#include <base/string.h>
 
 #include <string>
 
@@ -54,4 +55,14 @@ public:
     }
 };
 
+class failed_commands : public base::exception
+{
+public:
+    failed_commands(unsigned n, unsigned t, int c)
+        : base::exception(base::to_string(n) + " of " + base::to_string(t)
+                + " commands failed.", c)
+    {
+    }
+};
+
 }
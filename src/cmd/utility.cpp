@@ -39,6 +39,50 @@ split(const std::string& s, const std::string& d)
         std::make_pair(s.substr(0, i), s.substr(i + 1));
 }
 
+void split_command_line(std::vector<std::string>& out, const std::string& s)
+{
+    std::string a;
+    bool in_word = false;
+    char quote = 0;
+    for (std::string::size_type i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        if (quote == '\'') {
+            if (c == quote) {
+                quote = 0;
+            } else {
+                a += c;
+            }
+        } else if (c == '\\' && i + 1 < s.size()) {
+            a += s[++i];
+            in_word = true;
+        } else if (quote == '"') {
+            if (c == quote) {
+                quote = 0;
+            } else {
+                a += c;
+            }
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+            in_word = true;
+        } else if (c == ' ' || c == '\t') {
+            if (in_word) {
+                out.push_back(a);
+                a.clear();
+                in_word = false;
+            }
+        } else {
+            a += c;
+            in_word = true;
+        }
+    }
+    if (quote != 0) {
+        throw invalid_arguments("Quote is not closed in '" + s + "'.");
+    }
+    if (in_word) {
+        out.push_back(a);
+    }
+}
+
 }
 
 }
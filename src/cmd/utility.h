@@ -37,6 +37,14 @@ void split(std::vector<std::string>& out,
  */
 std::pair<std::string, std::string> split(const std::string& s,
         const std::string& d = " ");
+
+/**
+ * @brief Splits command line to arguments like shell does, honouring
+ *        single and double quotes and backslash escapes.
+ * @param s Command line.
+ * @throw invalid_arguments if quote is not closed.
+ */
+void split_command_line(std::vector<std::string>& out, const std::string& s);
 }
 
 }
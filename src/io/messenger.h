@@ -1,6 +1,10 @@
 #pragma once
 
 #include <iostream>
+#include <sstream>
+#include <string>
+
+#include <pthread.h>
 
 namespace io {
 
@@ -29,6 +33,7 @@ public:
 private:
     messenger()
     {
+        pthread_key_create(&m_key, 0);
     }
 
     messenger(const messenger&);
@@ -41,10 +46,26 @@ private:
     /// @name Output.
     /// @{
 public:
+    /// @brief Access to the stream, where calling thread writes messages.
+    std::ostream& stream()
+    {
+        std::ostream* s = static_cast<std::ostream*>(pthread_getspecific(m_key));
+        return s == 0 ? std::cout : *s;
+    }
+
+    /**
+     * @brief Redirects messages of calling thread to the given stream.
+     * @param s Stream, or null to write to the standard output.
+     */
+    void redirect(std::ostream* s)
+    {
+        pthread_setspecific(m_key, s);
+    }
+
     /// @brief Puts end of line to stream and flushes it.
     messenger& operator<<(endl_type input)
     {
-        std::cout << std::endl;
+        stream() << std::endl;
         return *this;
     }
 
@@ -55,12 +76,49 @@ public:
     template <typename T>
     messenger& operator <<(const T& t)
     {
-        std::cout << t;
+        stream() << t;
         return *this;
     }
     /// @}
+
+private:
+    pthread_key_t m_key;
 };
 
 extern messenger& mout;
 
+/**
+ * @class capture
+ * @brief Collects messages of calling thread while the object lives.
+ */
+class capture
+{
+public:
+    capture()
+        : m_previous(&mout.stream())
+    {
+        mout.redirect(&m_stream);
+    }
+
+    ~capture()
+    {
+        mout.redirect(m_previous == &std::cout ? 0 : m_previous);
+    }
+
+private:
+    capture(const capture&);
+    capture& operator=(const capture&);
+
+public:
+    /// @brief Gets the collected messages.
+    std::string str() const
+    {
+        return m_stream.str();
+    }
+
+private:
+    std::ostringstream m_stream;
+    std::ostream* m_previous;
+};
+
 }
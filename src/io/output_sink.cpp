@@ -0,0 +1,51 @@
+#include "output_sink.h"
+
+namespace io {
+
+output_sink::output_sink(std::ostream& o)
+    : std::ostream(0)
+    , m_buffer(o)
+{
+    rdbuf(&m_buffer);
+}
+
+output_sink::~output_sink()
+{
+    flush();
+}
+
+output_sink::buffer::buffer(std::ostream& o)
+    : m_target(o)
+{
+    setp(m_data, m_data + sizeof(m_data));
+}
+
+output_sink::buffer::int_type output_sink::buffer::overflow(int_type c)
+{
+    if (!write()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int output_sink::buffer::sync()
+{
+    if (!write()) {
+        return -1;
+    }
+    m_target.flush();
+    return 0;
+}
+
+bool output_sink::buffer::write()
+{
+    m_target.write(pbase(), pptr() - pbase());
+    setp(m_data, m_data + sizeof(m_data));
+    return m_target.good();
+}
+
+}
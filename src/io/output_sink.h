@@ -0,0 +1,53 @@
+#pragma once
+
+#include <iostream>
+#include <streambuf>
+
+namespace io {
+
+/**
+ * @class output_sink
+ * @brief Output stream with fixed buffer, where the rows are printed.
+ *
+ *        Rows are written to the target stream by large writes, when the
+ *        buffer is full or the sink is flushed, so printing takes constant
+ *        memory however many rows there are.
+ */
+class output_sink : public std::ostream
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param o Target stream.
+     */
+    explicit output_sink(std::ostream& o);
+
+    /// @brief Destructor, writes the rest of rows.
+    ~output_sink();
+
+private:
+    output_sink(const output_sink&);
+    output_sink& operator=(const output_sink&);
+
+private:
+    class buffer : public std::streambuf
+    {
+    public:
+        buffer(std::ostream& o);
+
+    protected:
+        virtual int_type overflow(int_type c);
+        virtual int sync();
+
+    private:
+        bool write();
+
+    private:
+        std::ostream& m_target;
+        char m_data[16 * 1024];
+    };
+
+    buffer m_buffer;
+};
+
+}
@@ -1,10 +1,11 @@
 #include "attachment_responce.h"
 
+#include <base/string.h>
 #include <io/csv_stream.h>
+#include <io/table_printer.h>
 #include <xml/xml_iterators.h>
 
 #include <cstdlib>
-#include <sstream>
 
 namespace lf {
 
@@ -33,44 +34,37 @@ void attachment_responce::read(xml::node<>* s)
             continue;
         }
         if (n == "size") {
-            m_size = std::atoi(v.c_str());
+            m_size = std::strtoll(v.c_str(), 0, 10);
             continue;
         }
     }
 }
 
-std::string attachment_responce::to_string(output_format f) const
+void attachment_responce::write(io::csv_ostream& cp) const
 {
-    std::stringstream m;
-    switch (f) {
-    case TABLE_FORMAT:
-        if (!m_filename.empty()) {
-            m << "Filename: " << m_filename << "\n";
-        }
-        if (!m_content_type.empty()) {
-            m << "Content Type: " << m_content_type << "\n";
-        }
-        if (!m_checksum.empty()) {
-            m << "Checksum: " << m_checksum << "\n";
-        }
-        if (!m_crc32.empty()) {
-            m << "CRC32: " << m_crc32 << "\n";
+    cp << m_filename << m_content_type << m_checksum << m_crc32 << m_url << m_size;
+}
+
+void attachment_responce::write(io::table_printer& tp) const
+{
+    unsigned n = 0;
+    const std::string* f[] = { &m_filename, &m_content_type, &m_checksum,
+        &m_crc32, &m_url };
+    const char* l[] = { "Filename: ", "Content Type: ", "Checksum: ",
+        "CRC32: ", "URL: " };
+    for (unsigned i = 0; i < sizeof(f) / sizeof(f[0]); ++i) {
+        if (f[i]->empty()) {
+            continue;
         }
-        if (!m_url.empty()) {
-            m << "URL: " << m_url << "\n";
+        if (n++ != 0) {
+            tp << " ";
         }
-        m << "Size: " << m_size << "\n";
-        break;
-    case CSV_FORMAT:
-    {
-        io::csv_ostream cp(&m);
-        cp << m_filename << m_content_type << m_checksum << m_crc32 << m_url << m_size;
+        tp << l[i] + *f[i];
     }
-    default:
-        break;
+    if (n != 0) {
+        tp << " ";
     }
-
-    return m.str();
+    tp << "Size: " + base::to_string(m_size);
 }
 
 }
@@ -6,6 +6,11 @@
 
 #include <string>
 
+namespace io {
+class csv_ostream;
+class table_printer;
+}
+
 namespace lf {
 
 /**
@@ -14,6 +19,13 @@ namespace lf {
  */
 class attachment_responce
 {
+public:
+    /// @brief Constructor.
+    attachment_responce()
+        : m_size(-1)
+    {
+    }
+
 public:
     /**
      * @brief Generates attachment_responce from xml node.
@@ -23,10 +35,19 @@ public:
 
 public:
     /**
-     * @brief Gets the string of responce to print.
-     * @param f Format of output string.
+     * @brief Writes the fields to the current csv row.
+     * @param cp Csv stream.
+     */
+    void write(io::csv_ostream& cp) const;
+
+    /**
+     * @brief Writes the fields as lines of the last table column.
+     *
+     *        First line ends the current row, every other line is a row
+     *        with empty other columns.
+     * @param tp Table printer.
      */
-    std::string to_string(output_format f) const;
+    void write(io::table_printer& tp) const;
 
 public:
     /// @brief Access to filiename.
@@ -59,8 +80,8 @@ public:
         return m_url;
     }
 
-    /// @brief Access to size.
-    int size() const
+    /// @brief Access to size, -1 if it is unknown.
+    long long size() const
     {
         return m_size;
     }
@@ -71,7 +92,7 @@ private:
     std::string m_checksum;
     std::string m_crc32;
     std::string m_url;
-    int m_size;
+    long long m_size;
 };
 
 }
@@ -0,0 +1,118 @@
+#include "chunk_sizer.h"
+
+#include <algorithm>
+
+namespace lf {
+
+namespace {
+
+/// Chunks are not smaller, as every chunk costs a request to server.
+long long s_min_chunk = 1024 * 1024;
+
+/// Chunks are not larger, to bound the data, which is repeated on failure.
+long long s_max_chunk = 100 * 1024 * 1024;
+
+/// Longest time of one chunk, so a failed chunk is repeated soon.
+double s_max_chunk_time = 10;
+
+/// Time of chunk is at least this many times the overhead of request.
+double s_overhead_ratio = 20;
+
+/// Uploads of this size at least are measured for throughput.
+curl_off_t s_min_sample = 64 * 1024;
+
+/// Weight of new measurement in the averages.
+double s_weight = 0.25;
+
+double seconds(CURL* c, CURLINFO i)
+{
+    curl_off_t v = 0;
+    curl_easy_getinfo(c, i, &v);
+    return v / 1e6;
+}
+
+void average(double& a, double x)
+{
+    a = a < 0 ? x : a + (x - a) * s_weight;
+}
+
+}
+
+chunk_sizer& chunk_sizer::get()
+{
+    static chunk_sizer s_instance;
+    return s_instance;
+}
+
+chunk_sizer::chunk_sizer()
+    : m_overhead(-1)
+    , m_round_trip(-1)
+    , m_rate(-1)
+{
+}
+
+void chunk_sizer::record(CURL* c, CURLcode r)
+{
+    long status = 0;
+    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &status);
+    if (r != CURLE_OK || status >= 400) {
+        return;
+    }
+    long n = 0;
+    curl_easy_getinfo(c, CURLINFO_NUM_CONNECTS, &n);
+    curl_off_t up = 0;
+    curl_easy_getinfo(c, CURLINFO_SIZE_UPLOAD_T, &up);
+    double p = seconds(c, CURLINFO_PRETRANSFER_TIME_T);
+    double s = seconds(c, CURLINFO_STARTTRANSFER_TIME_T) - p;
+    double t = seconds(c, CURLINFO_TOTAL_TIME_T) - p;
+    double h = seconds(c, CURLINFO_CONNECT_TIME_T)
+        - seconds(c, CURLINFO_NAMELOOKUP_TIME_T);
+    base::scoped_lock l(m_mutex);
+    if (n > 0 && h > 0) {
+        average(m_round_trip, h);
+    }
+    if (up < s_min_sample) {
+        if (s > 0) {
+            average(m_overhead, s);
+        }
+        return;
+    }
+    double o = m_overhead >= 0 ? m_overhead : std::max(m_round_trip, 0.0);
+    double x = std::max(t - o, t / 2);
+    if (x > 0) {
+        average(m_rate, up / x);
+    }
+}
+
+chunk_sizer::sizes chunk_sizer::plan(long long f, unsigned p)
+{
+    long long lo = s_min_chunk;
+    long long hi = s_max_chunk;
+    {
+        base::scoped_lock l(m_mutex);
+        if (m_rate > 0) {
+            double o = m_overhead >= 0 ? m_overhead : std::max(m_round_trip, 0.0);
+            hi = std::max(lo, std::min(hi,
+                        static_cast<long long>(m_rate * s_max_chunk_time)));
+            lo = std::max(lo, std::min(hi,
+                        static_cast<long long>(m_rate * o * s_overhead_ratio)));
+        }
+    }
+    sizes r;
+    if (f < 2 * lo) {
+        r.push_back(f);
+        return r;
+    }
+    p = std::max(p, 1u);
+    long long b = f - lo;
+    long long w = (b + p * hi - 1) / (p * hi);
+    long long k = std::max(1LL, std::min(w * p, b / lo));
+    long long c = (b + k - 1) / k;
+    for (long long o = 0; o < b; o += c) {
+        r.push_back(std::min(c, b - o));
+    }
+    r.push_back(lo);
+    return r;
+}
+
+}
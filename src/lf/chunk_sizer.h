@@ -0,0 +1,63 @@
+#pragma once
+
+#include <base/mutex.h>
+
+#include <curl/curl.h>
+
+#include <vector>
+
+namespace lf {
+
+/**
+ * @class chunk_sizer
+ * @brief Picks the sizes of chunks, which files are uploaded by.
+ *
+ *        Every finished request is measured. Small requests give the
+ *        overhead of request, which is the round trip with the processing
+ *        time of server, uploads give the throughput of one transfer.
+ *        Chunks are made large enough, that the overhead is a small part of
+ *        their time, but not so large, that a failed chunk takes long to
+ *        repeat. Chunks are split in whole rounds of parallel uploads, so
+ *        all the uploads are busy, and the last chunk, which is sent when
+ *        all the others are done, is small.
+ *        Until the first measurements, chunks are only bounded by size.
+ */
+class chunk_sizer
+{
+public:
+    typedef std::vector<long long> sizes;
+
+public:
+    /// @brief Access to the sizer of process.
+    static chunk_sizer& get();
+
+private:
+    chunk_sizer();
+    chunk_sizer(const chunk_sizer&);
+    chunk_sizer& operator=(const chunk_sizer&);
+
+public:
+    /**
+     * @brief Measures the finished request of handle.
+     * @param c Handle.
+     * @param r Result of request.
+     */
+    void record(CURL* c, CURLcode r);
+
+    /**
+     * @brief Splits the file to chunks.
+     * @param f Size of file.
+     * @param p Count of chunks uploaded simultaneously.
+     * @return Sizes of chunks in order, one size if the file should be
+     *         uploaded as a whole.
+     */
+    sizes plan(long long f, unsigned p);
+
+private:
+    base::mutex m_mutex;
+    double m_overhead;
+    double m_round_trip;
+    double m_rate;
+};
+
+}
@@ -0,0 +1,112 @@
+#include "connection_pool.h"
+#include "chunk_sizer.h"
+#include "exceptions.h"
+#include "timing_log.h"
+
+namespace lf {
+
+namespace {
+
+unsigned s_max_idle_handles = 16;
+
+}
+
+connection_pool::connection_pool()
+    : m_share(0)
+{
+    m_share = curl_share_init();
+    if (m_share == 0) {
+        throw curl_error("Failed to initialize CURL");
+    }
+    curl_share_setopt(m_share, CURLSHOPT_LOCKFUNC, &connection_pool::lock);
+    curl_share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, &connection_pool::unlock);
+    curl_share_setopt(m_share, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+}
+
+connection_pool::~connection_pool()
+{
+    std::vector<CURL*>::iterator i = m_handles.begin();
+    for (; i != m_handles.end(); ++i) {
+        curl_easy_cleanup(*i);
+    }
+    curl_share_cleanup(m_share);
+}
+
+CURL* connection_pool::acquire()
+{
+    CURL* c = 0;
+    {
+        base::scoped_lock l(m_mutex);
+        if (!m_handles.empty()) {
+            c = m_handles.back();
+            m_handles.pop_back();
+        }
+    }
+    if (c == 0) {
+        c = curl_easy_init();
+        if (c == 0) {
+            throw curl_error("Failed to initialize CURL");
+        }
+    }
+    curl_easy_setopt(c, CURLOPT_SHARE, m_share);
+    return c;
+}
+
+CURL* connection_pool::duplicate(CURL* c)
+{
+    CURL* d = curl_easy_duphandle(c);
+    if (d == 0) {
+        throw curl_error("Failed to initialize CURL");
+    }
+    curl_easy_setopt(d, CURLOPT_SHARE, m_share);
+    return d;
+}
+
+void connection_pool::release(CURL* c)
+{
+    curl_easy_reset(c);
+    base::scoped_lock l(m_mutex);
+    if (m_handles.size() < s_max_idle_handles) {
+        m_handles.push_back(c);
+        return;
+    }
+    curl_easy_cleanup(c);
+}
+
+void connection_pool::account(CURL* c, CURLcode r, curl_off_t d)
+{
+    timing_log* t = timing_log::current();
+    if (t != 0) {
+        t->record(c, r, d);
+    }
+    chunk_sizer::get().record(c, r);
+    long n = 0;
+    curl_easy_getinfo(c, CURLINFO_NUM_CONNECTS, &n);
+    base::scoped_lock l(m_mutex);
+    ++m_statistics.m_requests;
+    m_statistics.m_connections += n;
+    if (n == 0) {
+        ++m_statistics.m_reused;
+    }
+}
+
+connection_pool::statistics connection_pool::get_statistics()
+{
+    base::scoped_lock l(m_mutex);
+    return m_statistics;
+}
+
+void connection_pool::lock(CURL*, curl_lock_data d, curl_lock_access, void* p)
+{
+    static_cast<connection_pool*>(p)->m_locks[d].lock();
+}
+
+void connection_pool::unlock(CURL*, curl_lock_data d, void* p)
+{
+    static_cast<connection_pool*>(p)->m_locks[d].unlock();
+}
+
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <base/mutex.h>
+
+#include <curl/curl.h>
+
+#include <vector>
+
+namespace lf {
+
+/**
+ * @class connection_pool
+ * @brief Pool of CURL handles, which share connections, DNS and TLS
+ *        session caches.
+ *
+ *        All the handles given by pool are attached to the same share
+ *        object, so a connection opened by one operation of engine is
+ *        reused by the next ones, including the simultaneous transfers.
+ *        Pool can be used from several threads.
+ */
+class connection_pool
+{
+public:
+    /**
+     * @struct statistics
+     * @brief Counters of requests and connections.
+     */
+    struct statistics
+    {
+        statistics()
+            : m_requests(0)
+            , m_connections(0)
+            , m_reused(0)
+        {
+        }
+
+        /// @brief Count of performed requests.
+        unsigned long m_requests;
+
+        /// @brief Count of opened connections.
+        unsigned long m_connections;
+
+        /// @brief Count of requests done on already opened connection.
+        unsigned long m_reused;
+    };
+
+public:
+    /**
+     * @brief Constructor.
+     * @throw curl_error.
+     */
+    connection_pool();
+
+    /// @brief Destructor.
+    ~connection_pool();
+
+private:
+    connection_pool(const connection_pool&);
+    connection_pool& operator=(const connection_pool&);
+
+public:
+    /**
+     * @brief Gets the handle with default options.
+     * @throw curl_error.
+     */
+    CURL* acquire();
+
+    /**
+     * @brief Gets the copy of given handle, which has the same options.
+     * @param c Handle to copy.
+     * @throw curl_error.
+     */
+    CURL* duplicate(CURL* c);
+
+    /**
+     * @brief Returns the handle to the pool.
+     * @param c Handle given by acquire or duplicate.
+     */
+    void release(CURL* c);
+
+public:
+    /**
+     * @brief Updates the counters by the finished request of given handle,
+     *        and writes its timings to the log of calling thread.
+     * @param c Handle of finished request.
+     * @param r Result of request.
+     * @param d Size of decoded response body, -1 if the body was not
+     *        collected, so it was not decoded either.
+     */
+    void account(CURL* c, CURLcode r, curl_off_t d);
+
+    /// @brief Gets the counters.
+    statistics get_statistics();
+
+private:
+    static void lock(CURL* c, curl_lock_data d, curl_lock_access a, void* p);
+    static void unlock(CURL* c, curl_lock_data d, void* p);
+
+private:
+    CURLSH* m_share;
+    base::mutex m_locks[CURL_LOCK_DATA_LAST];
+    base::mutex m_mutex;
+    std::vector<CURL*> m_handles;
+    statistics m_statistics;
+};
+
+}
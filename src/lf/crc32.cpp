@@ -0,0 +1,247 @@
+#include "crc32.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LF_CRC32_PCLMUL 1
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+namespace lf {
+
+namespace {
+
+uint32_t s_polynomial = 0xedb88320;
+
+/**
+ * Tables for slicing by 8 bytes. The first one is the usual byte table,
+ * the next ones give the CRC of a byte followed by 1..7 zero bytes.
+ */
+class crc32_tables
+{
+public:
+    crc32_tables()
+    {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (c >> 1) ^ s_polynomial : c >> 1;
+            }
+            m_table[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int t = 1; t < 8; ++t) {
+                uint32_t c = m_table[t - 1][i];
+                m_table[t][i] = (c >> 8) ^ m_table[0][c & 0xff];
+            }
+        }
+    }
+
+public:
+    uint32_t m_table[8][256];
+};
+
+const crc32_tables s_tables;
+
+bool s_pclmul = crc32_pclmul_supported();
+
+/// Kernels work on the inverted CRC.
+uint32_t update_table(uint32_t c, const unsigned char* d, size_t n)
+{
+    const uint32_t (*t)[256] = s_tables.m_table;
+    while (n != 0 && (reinterpret_cast<size_t>(d) & 7) != 0) {
+        c = (c >> 8) ^ t[0][(c ^ *d++) & 0xff];
+        --n;
+    }
+    while (n >= 8) {
+        uint32_t a = c ^ (d[0] | d[1] << 8 | d[2] << 16
+                | static_cast<uint32_t>(d[3]) << 24);
+        c = t[7][a & 0xff] ^ t[6][(a >> 8) & 0xff]
+            ^ t[5][(a >> 16) & 0xff] ^ t[4][a >> 24]
+            ^ t[3][d[4]] ^ t[2][d[5]] ^ t[1][d[6]] ^ t[0][d[7]];
+        d += 8;
+        n -= 8;
+    }
+    while (n-- != 0) {
+        c = (c >> 8) ^ t[0][(c ^ *d++) & 0xff];
+    }
+    return c;
+}
+
+#ifdef LF_CRC32_PCLMUL
+
+/**
+ * Folds 64-byte blocks in four lanes, then reduces them to 32 bits by
+ * Barrett reduction. See "Fast CRC Computation for Generic Polynomials
+ * Using PCLMULQDQ Instruction", Intel, 2009. Size must be a multiple of 16
+ * and at least 64.
+ */
+__attribute__((target("pclmul,sse4.1")))
+uint32_t update_pclmul(uint32_t c, const unsigned char* d, size_t n)
+{
+    const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596LL, 0x0154442bd4LL);
+    const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009eLL, 0x01751997d0LL);
+    const __m128i k5k0 = _mm_set_epi64x(0, 0x0163cd6124LL);
+    const __m128i poly = _mm_set_epi64x(0x01f7011641LL, 0x01db710641LL);
+    const __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    const __m128i* p = reinterpret_cast<const __m128i*>(d);
+    __m128i x1 = _mm_loadu_si128(p);
+    __m128i x2 = _mm_loadu_si128(p + 1);
+    __m128i x3 = _mm_loadu_si128(p + 2);
+    __m128i x4 = _mm_loadu_si128(p + 3);
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(c)));
+    p += 4;
+    n -= 64;
+
+    while (n >= 64) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+        __m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+        __m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+        __m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(p));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(p + 1));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(p + 2));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(p + 3));
+        p += 4;
+        n -= 64;
+    }
+
+    __m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    while (n >= 16) {
+        x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128(p)), x5);
+        ++p;
+        n -= 16;
+    }
+
+    // Fold 128 bits to 64 bits.
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask);
+    x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits.
+    x2 = _mm_and_si128(x1, mask);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+    x2 = _mm_and_si128(x2, mask);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+#endif
+
+uint32_t gf2_matrix_times(const uint32_t* m, uint32_t v)
+{
+    uint32_t s = 0;
+    while (v != 0) {
+        if (v & 1) {
+            s ^= *m;
+        }
+        v >>= 1;
+        ++m;
+    }
+    return s;
+}
+
+void gf2_matrix_square(uint32_t* s, const uint32_t* m)
+{
+    for (int i = 0; i < 32; ++i) {
+        s[i] = gf2_matrix_times(m, m[i]);
+    }
+}
+
+}
+
+uint32_t crc32_update_portable(uint32_t c, const char* d, size_t n)
+{
+    return ~update_table(~c, reinterpret_cast<const unsigned char*>(d), n);
+}
+
+uint32_t crc32_update_pclmul(uint32_t c, const char* d, size_t n)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(d);
+    c = ~c;
+#ifdef LF_CRC32_PCLMUL
+    if (n >= 64) {
+        size_t m = n & ~static_cast<size_t>(15);
+        c = update_pclmul(c, p, m);
+        p += m;
+        n -= m;
+    }
+#endif
+    return ~update_table(c, p, n);
+}
+
+bool crc32_pclmul_supported()
+{
+#ifdef LF_CRC32_PCLMUL
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#else
+    return false;
+#endif
+}
+
+uint32_t crc32_update(uint32_t c, const char* d, size_t n)
+{
+    if (s_pclmul) {
+        return crc32_update_pclmul(c, d, n);
+    }
+    return crc32_update_portable(c, d, n);
+}
+
+uint32_t crc32_combine(uint32_t c1, uint32_t c2, long long n2)
+{
+    if (n2 <= 0) {
+        return c1;
+    }
+    uint32_t even[32];
+    uint32_t odd[32];
+    // Operator for one zero bit.
+    odd[0] = s_polynomial;
+    uint32_t r = 1;
+    for (int i = 1; i < 32; ++i) {
+        odd[i] = r;
+        r <<= 1;
+    }
+    // Operators for two and four zero bits.
+    gf2_matrix_square(even, odd);
+    gf2_matrix_square(odd, even);
+    // Apply n2 zero bytes to c1.
+    do {
+        gf2_matrix_square(even, odd);
+        if (n2 & 1) {
+            c1 = gf2_matrix_times(even, c1);
+        }
+        n2 >>= 1;
+        if (n2 == 0) {
+            break;
+        }
+        gf2_matrix_square(odd, even);
+        if (n2 & 1) {
+            c1 = gf2_matrix_times(odd, c1);
+        }
+        n2 >>= 1;
+    } while (n2 != 0);
+    return c1 ^ c2;
+}
+
+}
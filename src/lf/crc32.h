@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+
+#include <stdint.h>
+
+namespace lf {
+
+/**
+ * @brief Updates CRC-32 (ISO-HDLC, as in zlib) by the next bytes of data.
+ *
+ *        Uses carry-less multiplication folding, when processor supports
+ *        PCLMULQDQ, and table lookup otherwise.
+ * @param c CRC-32 of the previous data, 0 for the beginning.
+ * @param d Data.
+ * @param n Size of data.
+ */
+uint32_t crc32_update(uint32_t c, const char* d, size_t n);
+
+/**
+ * @brief Gets CRC-32 of two concatenated blocks from their CRC-32s.
+ * @param c1 CRC-32 of the first block.
+ * @param c2 CRC-32 of the second block.
+ * @param n2 Size of the second block.
+ */
+uint32_t crc32_combine(uint32_t c1, uint32_t c2, long long n2);
+
+/**
+ * @brief Table lookup kernel of crc32_update.
+ */
+uint32_t crc32_update_portable(uint32_t c, const char* d, size_t n);
+
+/**
+ * @brief Carry-less multiplication kernel of crc32_update.
+ *
+ *        Must be called only when crc32_pclmul_supported returns true.
+ */
+uint32_t crc32_update_pclmul(uint32_t c, const char* d, size_t n);
+
+/// @brief Checks whether processor supports crc32_update_pclmul.
+bool crc32_pclmul_supported();
+
+}
@@ -13,6 +13,11 @@ enum validate_cert {
     NOT_VALIDATE
 };
 
+enum http_version {
+    HTTP_1_1,
+    HTTP_2
+};
+
 enum output_format {
     TABLE_FORMAT,
     CSV_FORMAT
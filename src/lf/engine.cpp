@@ -1,20 +1,38 @@
 #include "engine.h"
 #include "attachment_responce.h"
+#include "chunk_sizer.h"
 #include "exceptions.h"
+#include "file_scanner.h"
 #include "filelinks_responce.h"
+#include "integrity_check.h"
 #include "messages_responce.h"
 #include "message_responce.h"
-
+#include "mime_form.h"
+#include "rate_limiter.h"
+#include "responce_buffer.h"
+#include "retry_policy.h"
+#include "segmented_download.h"
+#include "transfer_queue.h"
+
+#include <base/shared_ptr.h>
 #include <base/string.h>
 #include <io/messenger.h>
+#include <io/output_sink.h>
 #include <xml/xml.h>
-#include <xml/xml_iterators.h>
+#include <xml/xml_extract.h>
+#include <xml/xml_stream.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
+#include <deque>
 #include <vector>
 
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 
 namespace lf {
 
@@ -22,15 +40,83 @@ namespace {
 
 unsigned s_normal_id_size = 22;
 
-std::string s_data;
+unsigned s_file_buffer_size = 1024 * 1024;
+
+long long s_segmented_download_size = 16 * 1024 * 1024;
+
+unsigned s_messages_ahead = 2;
+
+long long s_max_bytes_ahead = 1024LL * 1024 * 1024;
+
+long s_receive_buffer_size = 256 * 1024;
+
+long s_upload_buffer_size = 1024 * 1024;
+
+size_t data_parse(void* ptr, size_t size, size_t nmemb, xml::stream_parser* p)
+{
+    return p->feed(static_cast<char*>(ptr), size * nmemb) ? size * nmemb : 0;
+}
 
-size_t data_get(void* ptr, size_t size, size_t nmemb, FILE* stream)
+typedef xml::tag<'i', 'd'> id_tag;
+typedef xml::tag<'u', 'r', 'l'> url_tag;
+typedef xml::tag<'a', 'p', 'i', '_', 'k', 'e', 'y'> api_key_tag;
+typedef xml::tag<'s', 't', 'a', 't', 'u', 's'> status_tag;
+
+/**
+ * Gets the value of field of responce, which is a child of its root, without
+ * parsing the whole responce. Error responce is thrown with its message.
+ * Empty value is taken only if allow_empty is set.
+ */
+template <typename Field>
+std::string extract_field(const std::string& r, const std::string& request,
+        bool allow_empty = false)
 {
-    s_data += std::string(static_cast<char*>(ptr), nmemb);
-    if (stream != 0) {
-        fwrite(ptr, size, nmemb, stream);
+    const char* v = 0;
+    std::size_t n = 0;
+    xml::extract_result e = xml::extract<Field>(r.c_str(), v, n);
+    if (e == xml::extract_missing) {
+        throw request_error(request, r);
+    }
+    if (e == xml::extract_error) {
+        throw request_error(request, v != 0 ? std::string(v, n) : r);
+    }
+    if (n == 0 && !allow_empty) {
+        throw request_error(request, r);
+    }
+    return std::string(v, n);
+}
+
+/**
+ * Parses the responce into the document, which keeps the memory of its
+ * previous parses, so responces of similar size do not allocate.
+ */
+xml::document<>& parse(xml::document<>& d, const std::string& r)
+{
+    d.reset();
+    d.parse<xml::parse_fastest | xml::parse_no_utf8>(const_cast<char*>(r.c_str()));
+    return d;
+}
+
+std::string get_basename(const std::string& file)
+{
+    std::string::size_type i = file.find_last_of('/');
+    return i == std::string::npos ? file : file.substr(i + 1);
+}
+
+long long get_file_size(const std::string& file)
+{
+    struct stat sb;
+    if (stat(file.c_str(), &sb) != 0) {
+        return -1;
+    }
+    return sb.st_size;
+}
+
+void promote_file(const std::string& part, const std::string& file)
+{
+    if (rename(part.c_str(), file.c_str()) != 0) {
+        throw file_error(file, strerror(errno));
     }
-    return size * nmemb;
 }
 
 class curl_header_guard
@@ -52,80 +138,148 @@ private:
     struct curl_slist* m_slist;
 };
 
-class curl_form_guard
+/**
+ * Posts the form by the handle and clears it from handle, when the form is
+ * freed.
+ */
+class curl_mime_guard
 {
 public:
-    curl_form_guard(struct curl_httppost* f)
-        : m_formpost(f)
+    curl_mime_guard(CURL* c, mime_form& f)
+        : m_curl(c)
     {
+        f.post(c);
     }
 
-    ~curl_form_guard()
+    ~curl_mime_guard()
     {
-        curl_formfree(m_formpost);
+        curl_easy_setopt(m_curl, CURLOPT_MIMEPOST, static_cast<curl_mime*>(0));
     }
 
 private:
-    struct curl_httppost* m_formpost;
+    CURL* m_curl;
 };
+}
 
-class curl_file_guard
+/**
+ * @brief State of the engine, which is separate for every thread.
+ */
+struct engine::context
 {
-public:
-    curl_file_guard(CURL* c, FILE* f)
-        : m_curl(c)
-        , m_file(f)
+    context()
+        : m_pool(0)
+        , m_curl(0)
+        , m_upload_buffer_size(s_upload_buffer_size)
+        , m_http_version(HTTP_2)
+        , m_report_level(NORMAL)
     {
-        curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, m_file);
     }
 
-    ~curl_file_guard()
+    ~context()
     {
-        fclose(m_file);
-        curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, 0);
+        if (m_curl != 0) {
+            m_pool->release(m_curl);
+        }
     }
 
-private:
+    connection_pool* m_pool;
     CURL* m_curl;
-    FILE* m_file;
+    long m_upload_buffer_size;
+    http_version m_http_version;
+    report_level m_report_level;
+    std::vector<std::string> m_include;
+    std::vector<std::string> m_exclude;
+    responce_buffer m_responce;
+    xml::document<> m_document;
 };
 
-}
-
 void engine::init_curl(std::string key, report_level s, validate_cert v)
 {
-    if (m_curl != 0) {
-        curl_easy_cleanup(m_curl);
-    }
-    m_curl = curl_easy_init();
-    if (m_curl == 0) {
-        throw curl_error("Failed to initialize CURL");
-    }
-    curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, &data_get);
-    curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, 0);
+    context& x = m_context.get();
+    if (x.m_curl != 0) {
+        m_pool.release(x.m_curl);
+        x.m_curl = 0;
+    }
+    x.m_pool = &m_pool;
+    x.m_curl = m_pool.acquire();
+    x.m_responce.clear();
+    x.m_report_level = s;
+    {
+        base::scoped_lock l(m_mutex);
+        m_report_level = s;
+    }
+    CURL* c = x.m_curl;
+    x.m_responce.attach(c);
+    curl_easy_setopt(c, CURLOPT_UPLOAD_BUFFERSIZE, x.m_upload_buffer_size);
+    curl_easy_setopt(c, CURLOPT_HTTP_VERSION, x.m_http_version == HTTP_1_1
+            ? CURL_HTTP_VERSION_1_1 : CURL_HTTP_VERSION_2TLS);
+    // Responses of API are decoded by curl, downloads disable it.
+    curl_easy_setopt(c, CURLOPT_ACCEPT_ENCODING, "");
     if (!key.empty()) {
         key += ":x";
-        curl_easy_setopt(m_curl, CURLOPT_USERPWD, key.c_str());
+        curl_easy_setopt(c, CURLOPT_USERPWD, key.c_str());
     }
     if (v == NOT_VALIDATE) {
-        curl_easy_setopt(m_curl, CURLOPT_SSL_VERIFYPEER, false);
+        curl_easy_setopt(c, CURLOPT_SSL_VERIFYPEER, false);
     }
     if (s == VERBOSE) {
-        curl_easy_setopt(m_curl, CURLOPT_VERBOSE, 1L);
+        curl_easy_setopt(c, CURLOPT_VERBOSE, 1L);
     }
 }
 
+void engine::set_upload_buffer_size(long n)
+{
+    m_context.get().m_upload_buffer_size = n;
+}
+
+void engine::set_http_version(http_version v)
+{
+    m_context.get().m_http_version = v;
+}
+
+void engine::set_file_patterns(const std::vector<std::string>& include,
+        const std::vector<std::string>& exclude)
+{
+    context& x = m_context.get();
+    x.m_include = include;
+    x.m_exclude = exclude;
+}
+
+xml::document<>& engine::document() const
+{
+    return m_context.get().m_document;
+}
+
+CURL* engine::handle()
+{
+    return m_context.get().m_curl;
+}
+
 engine::engine()
-    : m_curl(0)
+    : m_pool()
+    , m_context()
+    , m_mutex()
+    , m_report_level(NORMAL)
 {
 }
 
 engine::~engine()
 {
-    if (m_curl != 0) {
-        curl_easy_cleanup(m_curl);
-        m_curl = 0;
+}
+
+void engine::report_statistics()
+{
+    connection_pool::statistics st = m_pool.get_statistics();
+    retry_policy::statistics rt = retry_policy::get().get_statistics();
+    base::scoped_lock l(m_mutex);
+    if (m_report_level < VERBOSE || st.m_requests == 0) {
+        return;
     }
+    io::mout << "Requests: " << st.m_requests
+        << ", opened connections: " << st.m_connections
+        << ", reused connections: " << st.m_reused
+        << ", retries: " << rt.m_retries
+        << ", backoff time: " << rt.m_backoff << " ms" << io::endl;
 }
 
 std::string engine::send(std::string server,
@@ -134,16 +288,14 @@ std::string engine::send(std::string server,
         const std::string& subject,
         const std::string& message,
         const strings& fs,
+        unsigned p,
+        long long c,
         report_level s,
         validate_cert v)
 {
     init_curl(key, s, v);
-    std::set<std::string> attachments;
-    strings::const_iterator i = fs.begin();
-    for (; i != fs.end(); ++i) {
-        std::string a = attach_impl(server, *i, s);
-        attachments.insert(a);
-    }
+    std::vector<std::string> ids = attach_impl(server, fs, p, c, s);
+    std::set<std::string> attachments(ids.begin(), ids.end());
     return send_attachments_impl(server, user, subject, message,
             attachments, s);
 }
@@ -164,14 +316,13 @@ std::string engine::send_attachments(std::string server,
 void engine::attach(std::string server,
         const std::string& key,
         const strings& fs,
+        unsigned p,
+        long long c,
         report_level s,
         validate_cert v)
 {
     init_curl(key, s, v);
-    strings::const_iterator i = fs.begin();
-    for (; i != fs.end(); ++i) {
-        attach_impl(server, *i, s);
-    }
+    attach_impl(server, fs, p, c, s);
 }
 
 void engine::attach(std::string server,
@@ -185,35 +336,18 @@ void engine::attach(std::string server,
 {
     init_curl(key, s, v);
     server += "/attachments";
-    curl_easy_setopt(m_curl, CURLOPT_URL, server.c_str());
-    struct curl_httppost* formpost = NULL;
-    struct curl_httppost* lastptr = NULL;
-    curl_formadd(&formpost,
-            &lastptr,
-            CURLFORM_COPYNAME, "Filedata",
-            CURLFORM_FILE, file.c_str(),
-            CURLFORM_END);
-    curl_formadd(&formpost,
-            &lastptr,
-            CURLFORM_COPYNAME, "name",
-            CURLFORM_COPYCONTENTS, filename.c_str(),
-            CURLFORM_END);
-    curl_formadd(&formpost,
-            &lastptr,
-            CURLFORM_COPYNAME, "chunk",
-            CURLFORM_COPYCONTENTS, base::to_string(chunk_id).c_str(),
-            CURLFORM_END);
-    curl_formadd(&formpost,
-            &lastptr,
-            CURLFORM_COPYNAME, "chunks",
-            CURLFORM_COPYCONTENTS, base::to_string(num_chunks).c_str(),
-            CURLFORM_END);
-    curl_form_guard fg(formpost);
-    curl_easy_setopt(m_curl, CURLOPT_HTTPPOST, formpost);
+    curl_easy_setopt(handle(), CURLOPT_URL, server.c_str());
+    mime_form form(handle());
+    form.add_file("Filedata", file, get_basename(file));
+    form.add_field("name", filename);
+    form.add_field("chunk", base::to_string(chunk_id));
+    form.add_field("chunks", base::to_string(num_chunks));
+    curl_mime_guard mg(handle(), form);
     if (s >= NORMAL) {
         io::mout << "Uploading chunk '" << file << "'." << io::endl;
     }
-    process_attach_chunk_responce(perform(), s);
+    // Chunk is stored by its number, so it can be uploaded again.
+    process_attach_chunk_responce(perform(num_chunks > 1), s);
 }
 
 void engine::messages(std::string server,
@@ -224,8 +358,10 @@ void engine::messages(std::string server,
         report_level s,
         validate_cert v)
 {
-    std::string r = messages_impl(server, key, l, f, s, v);
-    process_output_responce<messages_responce>(r, s, of);
+    io::output_sink o(io::mout.stream());
+    messages_responce m(&o, of);
+    xml::stream_parser p("message", m);
+    messages_impl(server, key, l, f, s, v, p);
 }
 
 void engine::message(std::string server,
@@ -255,21 +391,441 @@ std::string get_filename(const std::string& url)
     return url.substr(i + 1);
 }
 
+/**
+ * Files of one command, which are downloaded through transfer queue.
+ * Failure of a file is reported and counted, so the other files continue.
+ */
+class download_batch
+{
+public:
+    download_batch()
+        : m_failures(0)
+    {
+    }
+
+    virtual ~download_batch()
+    {
+    }
+
+public:
+    void failed(const base::exception& e)
+    {
+        io::mout << "Error: " << e.message() << io::endl;
+        ++m_failures;
+    }
+
+    virtual void file_done(long long)
+    {
+    }
+
+    unsigned failures() const
+    {
+        return m_failures;
+    }
+
+private:
+    unsigned m_failures;
+};
+
+}
+
+/**
+ * Downloads the file to '<file>.part', continuing from the data which is
+ * already there, and renames it to '<file>' when the download is complete.
+ * Data is written to file through the buffer of fixed size, so memory usage
+ * does not depend on the size of file. When server does not honour the
+ * range, part file is truncated and written from the start. Data is hashed
+ * as it arrives and the file fails, if hashes do not match the checksums
+ * given by server.
+ */
+class engine::download_transfer : public transfer
+{
+public:
+    download_transfer(const std::string& url, const std::string& path,
+            const std::string& name, long long size,
+            const integrity_check& c, report_level s, download_batch* b)
+        : m_url(url)
+        , m_name(name)
+        , m_file(path.empty() ? name : path + "/" + name)
+        , m_part(m_file + ".part")
+        , m_size(size)
+        , m_offset(0)
+        , m_check(c)
+        , m_corrupt(false)
+        , m_attempts(0)
+        , m_report_level(s)
+        , m_batch(b)
+        , m_handle(0)
+        , m_stream(0)
+        , m_checked(false)
+    {
+    }
+
+    ~download_transfer()
+    {
+        close();
+    }
+
+public:
+    virtual void prepare(CURL* c)
+    {
+        m_handle = c;
+        m_checked = false;
+        if (segmented_download::resumable(m_part)) {
+            // Part file of segments has holes, it can't be resumed from its end.
+            segmented_download::discard(m_part);
+        }
+        m_offset = get_file_size(m_part);
+        if (m_size >= 0 && m_offset > m_size) {
+            unlink(m_part.c_str());
+            m_offset = -1;
+        }
+        if (m_check.enabled() && m_check.size() != std::max(m_offset, 0LL)) {
+            m_check.reset();
+            if (m_offset > 0) {
+                m_check.update_file(m_part, m_offset);
+            }
+        }
+        m_stream = fopen(m_part.c_str(), m_offset > 0 ? "ab" : "wb");
+        if (m_stream == 0) {
+            throw file_error(m_part, strerror(errno));
+        }
+        m_buffer.resize(s_file_buffer_size);
+        setvbuf(m_stream, &m_buffer[0], _IOFBF, m_buffer.size());
+        if (m_report_level >= NORMAL) {
+            if (m_attempts == 0) {
+                io::mout << "Downloading file '" << m_name << "'" << io::endl;
+            }
+            if (m_offset > 0) {
+                io::mout << "Resuming file '" << m_name << "' from "
+                    << m_offset << " bytes." << io::endl;
+            }
+        }
+        curl_easy_setopt(c, CURLOPT_URL, m_url.c_str());
+        curl_easy_setopt(c, CURLOPT_FAILONERROR, 1L);
+        curl_easy_setopt(c, CURLOPT_BUFFERSIZE, s_receive_buffer_size);
+        curl_easy_setopt(c, CURLOPT_ACCEPT_ENCODING, static_cast<char*>(0));
+        curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, &download_transfer::write);
+        curl_easy_setopt(c, CURLOPT_WRITEDATA, this);
+        if (m_offset > 0) {
+            std::string r = base::to_string(m_offset) + "-";
+            curl_easy_setopt(c, CURLOPT_RANGE, r.c_str());
+        }
+    }
+
+    virtual void finish(const std::string&)
+    {
+        close();
+        long long o = get_file_size(m_part);
+        if (m_size >= 0 && o != m_size) {
+            throw download_error(m_file, "Size of downloaded data is "
+                    + base::to_string(o) + " bytes instead of "
+                    + base::to_string(m_size) + ".");
+        }
+        promote();
+    }
+
+    virtual void fail(CURLcode r)
+    {
+        close();
+        long c = 0;
+        curl_easy_getinfo(m_handle, CURLINFO_RESPONSE_CODE, &c);
+        if (c == 416 && m_offset > 0 && (m_size < 0 || m_offset == m_size)) {
+            // Part file already has all the data.
+            promote();
+            return;
+        }
+        transfer::fail(r);
+    }
+
+    virtual bool retry()
+    {
+        return !m_corrupt && ++m_attempts < retry_policy::s_attempts;
+    }
+
+    virtual bool give_up(const base::exception& e)
+    {
+        if (m_batch == 0) {
+            return false;
+        }
+        m_batch->failed(e);
+        complete();
+        return true;
+    }
+
+private:
+    void close()
+    {
+        if (m_stream != 0) {
+            fclose(m_stream);
+            m_stream = 0;
+        }
+        std::vector<char>().swap(m_buffer);
+    }
+
+    void complete()
+    {
+        if (m_batch != 0) {
+            m_batch->file_done(m_size);
+        }
+    }
+
+    void promote()
+    {
+        try {
+            m_check.verify(m_file);
+        } catch (download_error&) {
+            m_corrupt = true;
+            unlink(m_part.c_str());
+            throw;
+        }
+        promote_file(m_part, m_file);
+        complete();
+    }
+
+    static size_t write(void* ptr, size_t size, size_t nmemb, download_transfer* t)
+    {
+        if (rate_limiter::get().acquire(rate_limiter::DOWNLOAD,
+                    t->m_handle, size * nmemb) == 0) {
+            return CURL_WRITEFUNC_PAUSE;
+        }
+        if (!t->m_checked) {
+            t->m_checked = true;
+            long c = 0;
+            curl_easy_getinfo(t->m_handle, CURLINFO_RESPONSE_CODE, &c);
+            if (t->m_offset > 0 && c != 206) {
+                fflush(t->m_stream);
+                if (ftruncate(fileno(t->m_stream), 0) != 0) {
+                    return 0;
+                }
+                rewind(t->m_stream);
+                t->m_check.reset();
+            }
+        }
+        size_t n = fwrite(ptr, 1, size * nmemb, t->m_stream);
+        if (t->m_check.enabled()) {
+            t->m_check.update(static_cast<char*>(ptr), n);
+        }
+        return n;
+    }
+
+private:
+    std::string m_url;
+    std::string m_name;
+    std::string m_file;
+    std::string m_part;
+    long long m_size;
+    long long m_offset;
+    integrity_check m_check;
+    bool m_corrupt;
+    unsigned m_attempts;
+    report_level m_report_level;
+    download_batch* m_batch;
+    CURL* m_handle;
+    FILE* m_stream;
+    bool m_checked;
+    std::vector<char> m_buffer;
+};
+
+/**
+ * Downloads the files of several messages. Details of the next messages
+ * are fetched ahead, a bounded count at a time, while the files of earlier
+ * messages are downloaded. Fetching stops while too many bytes are queued
+ * for download.
+ */
+class engine::download_pipeline : public download_batch
+{
+public:
+    download_pipeline(transfer_queue& q, const std::string& server,
+            const std::string& path, unsigned n, report_level s)
+        : m_queue(q)
+        , m_server(server)
+        , m_path(path)
+        , m_segments(n)
+        , m_report_level(s)
+        , m_next(0)
+        , m_fetching(0)
+        , m_files(0)
+        , m_bytes(0)
+    {
+    }
+
+public:
+    void add_message(const std::string& id)
+    {
+        m_ids.push_back(id);
+    }
+
+    void start()
+    {
+        pump();
+    }
+
+    void message_done(const std::vector<attachment_responce>& a)
+    {
+        --m_fetching;
+        std::vector<attachment_responce>::const_iterator i = a.begin();
+        for (; i != a.end(); ++i) {
+            ++m_files;
+            if (m_segments > 1 && i->size() >= s_segmented_download_size) {
+                m_large_files.push_back(*i);
+                continue;
+            }
+            m_bytes += std::max(i->size(), 0LL);
+            m_queue.push(new download_transfer(i->url(), m_path,
+                        i->filename(), i->size(),
+                        integrity_check(i->crc32(), i->checksum()),
+                        m_report_level, this));
+        }
+        pump();
+    }
+
+    void message_failed(const base::exception& e)
+    {
+        --m_fetching;
+        failed(e);
+        pump();
+    }
+
+    virtual void file_done(long long size)
+    {
+        m_bytes -= std::max(size, 0LL);
+        pump();
+    }
+
+    /// Document to parse the messages into, reused for every message.
+    xml::document<>& document()
+    {
+        return m_document;
+    }
+
+    /// Files, which are downloaded by several connections after the others.
+    const std::vector<attachment_responce>& large_files() const
+    {
+        return m_large_files;
+    }
+
+    unsigned files() const
+    {
+        return m_files;
+    }
+
+private:
+    void pump();
+
+private:
+    transfer_queue& m_queue;
+    std::string m_server;
+    std::string m_path;
+    unsigned m_segments;
+    report_level m_report_level;
+    std::vector<std::string> m_ids;
+    std::vector<std::string>::size_type m_next;
+    unsigned m_fetching;
+    unsigned m_files;
+    long long m_bytes;
+    std::vector<attachment_responce> m_large_files;
+    xml::document<> m_document;
+};
+
+/**
+ * Retrieves the message and queues the download of its attachments.
+ */
+class engine::message_transfer : public transfer
+{
+public:
+    message_transfer(download_pipeline& p, const std::string& server,
+            const std::string& id, report_level s)
+        : m_pipeline(p)
+        , m_url(server + "/message/" + id)
+        , m_id(id)
+        , m_report_level(s)
+        , m_attempts(0)
+        , m_invalid(false)
+    {
+    }
+
+public:
+    virtual void prepare(CURL* c)
+    {
+        curl_easy_setopt(c, CURLOPT_URL, m_url.c_str());
+        if (m_report_level >= NORMAL && m_attempts == 0) {
+            io::mout << "Retrieving attachments of message '" << m_id
+                << "'." << io::endl;
+        }
+    }
+
+    virtual void finish(const std::string& r)
+    {
+        message_responce m;
+        try {
+            m.read(&parse(m_pipeline.document(), r));
+        } catch (xml::parse_error&) {
+            m_invalid = true;
+            throw invalid_message_id(m_id);
+        }
+        m_pipeline.message_done(m.attachments());
+    }
+
+    virtual bool retry()
+    {
+        return !m_invalid && ++m_attempts < retry_policy::s_attempts;
+    }
+
+    virtual bool give_up(const base::exception& e)
+    {
+        m_pipeline.message_failed(e);
+        return true;
+    }
+
+private:
+    download_pipeline& m_pipeline;
+    std::string m_url;
+    std::string m_id;
+    report_level m_report_level;
+    unsigned m_attempts;
+    bool m_invalid;
+};
+
+void engine::download_pipeline::pump()
+{
+    while (m_next < m_ids.size() && m_fetching < s_messages_ahead
+            && m_bytes < s_max_bytes_ahead) {
+        ++m_fetching;
+        m_queue.push_front(new message_transfer(*this, m_server,
+                    m_ids[m_next++], m_report_level));
+    }
 }
 
 void engine::download(const std::set<std::string>& urls,
         const std::string& key,
         const std::string& path,
+        unsigned n,
+        unsigned p,
         report_level s,
         validate_cert v)
 {
     init_curl(key, s, v);
+    curl_header_guard hg(handle());
+    download_batch b;
+    transfer_queue q(m_pool, handle(), p);
     std::set<std::string>::const_iterator i = urls.begin();
-    curl_header_guard hg(m_curl);
-    while (i != urls.end()) {
+    for (; i != urls.end(); ++i) {
         std::string filename = get_filename(*i);
-        download_impl(*i, path, filename, s);
-        ++i;
+        if (n <= 1) {
+            q.push(new download_transfer(*i, path, filename, -1,
+                        integrity_check(), s, &b));
+            continue;
+        }
+        try {
+            download_impl(*i, path, filename, -1, n, integrity_check(), s);
+        } catch (base::exception& e) {
+            b.failed(e);
+        }
+    }
+    q.run();
+    if (b.failures() != 0) {
+        throw incomplete_download(b.failures(), urls.size());
     }
 }
 
@@ -277,22 +833,38 @@ void engine::download(std::string server,
         const std::string& key,
         const std::string& path,
         const std::string& id,
+        unsigned n,
+        unsigned p,
         report_level s,
         validate_cert v)
 {
     std::string r = message_impl(server, key, id, s, v,
         "Retrieving attachments of message.");
     try {
-        xml::document<> d;
-        d.parse<xml::parse_fastest | xml::parse_no_utf8>(const_cast<char*>(r.c_str()));
         message_responce m;
-        m.read(&d);
-        curl_header_guard hg(m_curl);
+        m.read(&parse(document(), r));
+        curl_header_guard hg(handle());
+        download_batch b;
+        transfer_queue q(m_pool, handle(), p);
         const std::vector<attachment_responce>& a = m.attachments();
         std::vector<attachment_responce>::const_iterator i = a.begin();
-        while (i != a.end()) {
-            download_impl(i->url(), path, i->filename(), s);
-            ++i;
+        for (; i != a.end(); ++i) {
+            if (n <= 1 || i->size() < s_segmented_download_size) {
+                q.push(new download_transfer(i->url(), path, i->filename(),
+                            i->size(), integrity_check(i->crc32(), i->checksum()),
+                            s, &b));
+                continue;
+            }
+            try {
+                download_impl(i->url(), path, i->filename(), i->size(), n,
+                        integrity_check(i->crc32(), i->checksum()), s);
+            } catch (base::exception& e) {
+                b.failed(e);
+            }
+        }
+        q.run();
+        if (b.failures() != 0) {
+            throw incomplete_download(b.failures(), a.size());
         }
     } catch (xml::parse_error&) {
         throw invalid_message_id(id);
@@ -304,16 +876,34 @@ void engine::download(std::string server,
         const std::string& path,
         const std::string& l,
         const std::string& f,
+        unsigned n,
+        unsigned p,
         report_level s,
         validate_cert v)
 {
-    std::string r = messages_impl(server, key, l, f, s, v);
-    xml::document<> d;
-    d.parse<xml::parse_fastest | xml::parse_no_utf8>(const_cast<char*>(r.c_str()));
     messages_responce m;
-    m.read(&d);
+    xml::stream_parser mp("message", m);
+    messages_impl(server, key, l, f, s, v, mp);
+    curl_header_guard hg(handle());
+    transfer_queue q(m_pool, handle(), p);
+    download_pipeline dp(q, server, path, n, s);
     for (unsigned i = 0; i < m.size(); ++i) {
-        download(server, path, key, m.id(i), s, v);
+        dp.add_message(m.id(i));
+    }
+    dp.start();
+    q.run();
+    const std::vector<attachment_responce>& a = dp.large_files();
+    std::vector<attachment_responce>::const_iterator i = a.begin();
+    for (; i != a.end(); ++i) {
+        try {
+            download_impl(i->url(), path, i->filename(), i->size(), n,
+                    integrity_check(i->crc32(), i->checksum()), s);
+        } catch (base::exception& e) {
+            dp.failed(e);
+        }
+    }
+    if (dp.failures() != 0) {
+        throw incomplete_download(dp.failures(), dp.files());
     }
 }
 
@@ -327,8 +917,8 @@ std::string engine::file_request(std::string server,
 {
     init_curl(key, s, v);
     server += "/requests";
-    curl_easy_setopt(m_curl, CURLOPT_URL, server.c_str());
-    curl_header_guard hg(m_curl);
+    curl_easy_setopt(handle(), CURLOPT_URL, server.c_str());
+    curl_header_guard hg(handle());
     std::string data = std::string(
 "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\
   <request>\
@@ -338,8 +928,7 @@ std::string engine::file_request(std::string server,
     <send_email>true</send_email>\
 ");
     data += "</request>\n";
-    curl_easy_setopt(m_curl, CURLOPT_HTTPPOST, 0);
-    curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS, data.c_str());
+    curl_easy_setopt(handle(), CURLOPT_POSTFIELDS, data.c_str());
     if (s >= NORMAL) {
         io::mout << "Sending file request to user '" << user << "'" << io::endl;
     }
@@ -352,23 +941,10 @@ std::string engine::get_api_key(std::string server,
         report_level s,
         validate_cert v)
 {
-    if (m_curl == 0) {
-        m_curl = curl_easy_init();
-    }
-    if (m_curl == 0) {
-        throw curl_error("Failed to initialize CURL");
-    }
-    curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, &data_get);
-    curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, 0);
-    if (v == NOT_VALIDATE) {
-        curl_easy_setopt(m_curl, CURLOPT_SSL_VERIFYPEER, false);
-    }
-    if (s == VERBOSE) {
-        curl_easy_setopt(m_curl, CURLOPT_VERBOSE, 1L);
-    }
+    init_curl("", s, v);
     server += "/login";
-    curl_easy_setopt(m_curl, CURLOPT_URL, server.c_str());
-    curl_header_guard hg(m_curl);
+    curl_easy_setopt(handle(), CURLOPT_URL, server.c_str());
+    curl_header_guard hg(handle());
     std::string data = std::string(
 "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\
   <user>\
@@ -376,8 +952,7 @@ std::string engine::get_api_key(std::string server,
     <password>") + password + std::string("</password>\
 ");
     data += "</user>\n";
-    curl_easy_setopt(m_curl, CURLOPT_HTTPPOST, 0);
-    curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS, data.c_str());
+    curl_easy_setopt(handle(), CURLOPT_POSTFIELDS, data.c_str());
     if (s >= NORMAL) {
         io::mout << "Getting API key for user '" << user << "'" << io::endl;
     }
@@ -416,9 +991,9 @@ void engine::delete_filelink(std::string server,
     init_curl(key, s, v);
     server += "/link/";
     server += id;
-    curl_easy_setopt(m_curl, CURLOPT_URL, server.c_str());
-    curl_header_guard hg(m_curl);
-    curl_easy_setopt(m_curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+    curl_easy_setopt(handle(), CURLOPT_URL, server.c_str());
+    curl_header_guard hg(handle());
+    curl_easy_setopt(handle(), CURLOPT_CUSTOMREQUEST, "DELETE");
     if (s >= NORMAL) {
         io::mout << "Deleting filelink with id '" << id << "'" << io::endl;
     }
@@ -442,12 +1017,15 @@ void engine::filelinks(std::string server,
         server += "?limit=";
         server += limit;
     }
-    curl_easy_setopt(m_curl, CURLOPT_URL, server.c_str());
-    curl_header_guard hg(m_curl);
+    curl_easy_setopt(handle(), CURLOPT_URL, server.c_str());
+    curl_header_guard hg(handle());
     if (s >= NORMAL) {
         io::mout << "Getting filelinks from the server." << io::endl;
     }
-    process_output_responce<filelinks_responce>(perform(), s, of);
+    io::output_sink o(io::mout.stream());
+    filelinks_responce r(&o, of);
+    xml::stream_parser p("link", r);
+    perform(p);
 }
 
 void engine::delete_attachments(std::string server,
@@ -458,12 +1036,12 @@ void engine::delete_attachments(std::string server,
 {
     init_curl(key, s, v);
     server += "/attachment/";
-    curl_easy_setopt(m_curl, CURLOPT_CUSTOMREQUEST, "DELETE");
-    curl_header_guard hg(m_curl);
+    curl_easy_setopt(handle(), CURLOPT_CUSTOMREQUEST, "DELETE");
+    curl_header_guard hg(handle());
     std::set<std::string>::const_iterator i = ids.begin();
     for (; i != ids.end(); ++i) {
         std::string x = server + (*i);
-        curl_easy_setopt(m_curl, CURLOPT_URL, x.c_str());
+        curl_easy_setopt(handle(), CURLOPT_URL, x.c_str());
         if (s >= NORMAL) {
             io::mout << "Deleting attachment '" << *i << "'" << io::endl;
         }
@@ -484,8 +1062,8 @@ void engine::delete_attachments(std::string server,
     server += "/message/";
     server += id;
     server += "/delete_attachments";
-    curl_easy_setopt(m_curl, CURLOPT_URL, server.c_str());
-    curl_header_guard hg(m_curl);
+    curl_easy_setopt(handle(), CURLOPT_URL, server.c_str());
+    curl_header_guard hg(handle());
     if (s >= NORMAL) {
         io::mout << "Deleting attachments of the message." << io::endl;
     }
@@ -510,19 +1088,17 @@ void engine::filedrop(std::string server,
         const std::string& subject,
         const std::string& message,
         const strings& fs,
+        unsigned p,
+        long long c,
         report_level s,
         validate_cert v)
 {
     std::string key = get_filedrop_api_key(server, s, v);
     init_curl(key, s, v);
-    strings::const_iterator i = fs.begin();
-    strings rs;
     std::string url = get_server_from_filedrop(server);
-    for (; i != fs.end(); ++i) {
-        std::string id = attach_impl(url, *i, s);
-        rs.insert(id);
-    }
-    curl_easy_setopt(m_curl, CURLOPT_USERPWD, "");
+    std::vector<std::string> ids = attach_impl(url, fs, p, c, s);
+    strings rs(ids.begin(), ids.end());
+    curl_easy_setopt(handle(), CURLOPT_USERPWD, "");
     filedrop_attachments_impl(server, key, user, subject, message,
             rs, s);
 }
@@ -545,16 +1121,10 @@ std::string engine::attach_impl(std::string server,
         report_level s)
 {
     server += "/attachments";
-    curl_easy_setopt(m_curl, CURLOPT_URL, server.c_str());
-    struct curl_httppost* formpost = NULL;
-    struct curl_httppost* lastptr = NULL;
-    curl_formadd(&formpost,
-               &lastptr,
-               CURLFORM_COPYNAME, "Filedata",
-               CURLFORM_FILE, file.c_str(),
-               CURLFORM_END);
-    curl_form_guard fg(formpost);
-    curl_easy_setopt(m_curl, CURLOPT_HTTPPOST, formpost);
+    curl_easy_setopt(handle(), CURLOPT_URL, server.c_str());
+    mime_form form(handle());
+    form.add_file("Filedata", file, get_basename(file));
+    curl_mime_guard mg(handle(), form);
     if (s >= NORMAL) {
         io::mout << "Uploading file '" << file << "'." << io::endl;
     }
@@ -563,6 +1133,375 @@ std::string engine::attach_impl(std::string server,
     return r;
 }
 
+class engine::attach_transfer : public transfer
+{
+public:
+    attach_transfer(const engine& e, const std::string& url,
+            const std::string& file, report_level s, std::string& id)
+        : m_engine(e)
+        , m_url(url)
+        , m_file(file)
+        , m_report_level(s)
+        , m_id(id)
+        , m_form(0)
+    {
+    }
+
+    ~attach_transfer()
+    {
+        delete m_form;
+    }
+
+public:
+    virtual void prepare(CURL* c)
+    {
+        curl_easy_setopt(c, CURLOPT_URL, m_url.c_str());
+        delete m_form;
+        m_form = 0;
+        m_form = new mime_form(c);
+        m_form->add_file("Filedata", m_file, get_basename(m_file));
+        m_form->post(c);
+        if (m_report_level >= NORMAL) {
+            io::mout << "Uploading file '" << m_file << "'." << io::endl;
+        }
+    }
+
+    virtual void finish(const std::string& r)
+    {
+        m_engine.process_attach_responce(r, m_report_level);
+        m_id = r;
+    }
+
+private:
+    const engine& m_engine;
+    std::string m_url;
+    std::string m_file;
+    report_level m_report_level;
+    std::string& m_id;
+    mime_form* m_form;
+};
+
+namespace {
+
+/**
+ * State of the file, which is uploaded by chunks. The last chunk is queued
+ * only when all the others are uploaded, as server returns the ID of file
+ * in responce to it.
+ */
+class chunked_upload
+{
+public:
+    chunked_upload(transfer_queue& q, std::string& id)
+        : m_queue(q)
+        , m_id(id)
+        , m_remaining(0)
+        , m_last(0)
+    {
+    }
+
+    ~chunked_upload()
+    {
+        delete m_last;
+    }
+
+private:
+    chunked_upload(const chunked_upload&);
+    chunked_upload& operator=(const chunked_upload&);
+
+public:
+    void add(transfer* t)
+    {
+        ++m_remaining;
+        m_queue.push(t);
+    }
+
+    void add_front(transfer* t)
+    {
+        ++m_remaining;
+        m_queue.push_front(t);
+    }
+
+    void set_last(transfer* t)
+    {
+        m_last = t;
+    }
+
+    void chunk_done()
+    {
+        if (--m_remaining == 0 && m_last != 0) {
+            transfer* t = m_last;
+            m_last = 0;
+            m_queue.push(t);
+        }
+    }
+
+    void file_done(const std::string& id)
+    {
+        m_id = id;
+    }
+
+private:
+    transfer_queue& m_queue;
+    std::string& m_id;
+    unsigned m_remaining;
+    transfer* m_last;
+};
+
+}
+
+/**
+ * Uploads the given byte range of file as one chunk. Data is read straight
+ * from the source file, so no temporary files are created.
+ */
+class engine::chunk_transfer : public transfer
+{
+public:
+    chunk_transfer(const engine& e, const std::string& url,
+            const std::string& file, int chunk_id, int num_chunks,
+            long long offset, long long size, report_level s,
+            chunked_upload& u)
+        : m_engine(e)
+        , m_url(url)
+        , m_file(file)
+        , m_name(get_basename(file))
+        , m_chunk_id(chunk_id)
+        , m_num_chunks(num_chunks)
+        , m_offset(offset)
+        , m_size(size)
+        , m_parallel(0)
+        , m_attempts(0)
+        , m_report_level(s)
+        , m_upload(u)
+        , m_form(0)
+    {
+    }
+
+    /// Constructor of the first chunk of file, which is split by chunk_sizer.
+    chunk_transfer(const engine& e, const std::string& url,
+            const std::string& file, long long size, unsigned p,
+            report_level s, chunked_upload& u)
+        : m_engine(e)
+        , m_url(url)
+        , m_file(file)
+        , m_name(get_basename(file))
+        , m_chunk_id(1)
+        , m_num_chunks(0)
+        , m_offset(0)
+        , m_size(size)
+        , m_parallel(p)
+        , m_attempts(0)
+        , m_report_level(s)
+        , m_upload(u)
+        , m_form(0)
+    {
+    }
+
+    ~chunk_transfer()
+    {
+        delete m_form;
+    }
+
+public:
+    virtual void prepare(CURL* c)
+    {
+        if (m_num_chunks == 0) {
+            plan();
+        }
+        delete m_form;
+        m_form = 0;
+        m_form = new mime_form(c);
+        m_form->add_file("Filedata", m_file, m_name, m_offset, m_size);
+        m_form->add_field("name", m_name);
+        m_form->add_field("chunk", base::to_string(m_chunk_id));
+        m_form->add_field("chunks", base::to_string(m_num_chunks));
+        curl_easy_setopt(c, CURLOPT_URL, m_url.c_str());
+        m_form->post(c);
+        if (m_report_level >= NORMAL) {
+            io::mout << "Uploading chunk " << m_chunk_id << "/" << m_num_chunks
+                << " of file '" << m_file << "'." << io::endl;
+        }
+    }
+
+    virtual void finish(const std::string& r)
+    {
+        if (m_chunk_id == m_num_chunks && r.size() != s_normal_id_size) {
+            throw request_error("upload_chunk", r);
+        }
+        m_engine.process_attach_chunk_responce(r, m_report_level);
+        if (m_chunk_id == m_num_chunks) {
+            m_upload.file_done(r);
+        } else {
+            m_upload.chunk_done();
+        }
+    }
+
+    virtual bool retry()
+    {
+        if (++m_attempts >= retry_policy::s_attempts) {
+            return false;
+        }
+        if (m_report_level >= NORMAL) {
+            io::mout << "Retrying chunk " << m_chunk_id << "/" << m_num_chunks
+                << " of file '" << m_file << "'." << io::endl;
+        }
+        return true;
+    }
+
+private:
+    /**
+     * Splits the file, when its upload starts, so the chunks are sized by
+     * the measurements of the requests done till now. The other chunks are
+     * queued before the files waiting to start.
+     */
+    void plan()
+    {
+        chunk_sizer::sizes s = chunk_sizer::get().plan(m_size, m_parallel);
+        if (s.size() < 2) {
+            s.assign(1, m_size - m_size / 2);
+            s.push_back(m_size / 2);
+        }
+        m_num_chunks = static_cast<int>(s.size());
+        long long o = m_size;
+        for (int k = m_num_chunks; k > 1; --k) {
+            o -= s[k - 1];
+            transfer* t = new chunk_transfer(m_engine, m_url, m_file, k,
+                    m_num_chunks, o, s[k - 1], m_report_level, m_upload);
+            if (k == m_num_chunks) {
+                m_upload.set_last(t);
+            } else {
+                m_upload.add_front(t);
+            }
+        }
+        m_size = s[0];
+    }
+
+private:
+    const engine& m_engine;
+    std::string m_url;
+    std::string m_file;
+    std::string m_name;
+    int m_chunk_id;
+    int m_num_chunks;
+    long long m_offset;
+    long long m_size;
+    unsigned m_parallel;
+    unsigned m_attempts;
+    report_level m_report_level;
+    chunked_upload& m_upload;
+    mime_form* m_form;
+};
+
+/**
+ * Queues the uploads of files. Files of directories are queued as soon as
+ * the scanner finds them, so the uploads start while the scan goes on.
+ */
+class engine::upload_source : public transfer_source
+{
+public:
+    upload_source(const engine& e, const std::string& url, unsigned p,
+            long long c, report_level s, file_scanner& fs)
+        : m_engine(e)
+        , m_url(url)
+        , m_parallel(p)
+        , m_chunk_size(c)
+        , m_report_level(s)
+        , m_scanner(fs)
+    {
+    }
+
+public:
+    void add(transfer_queue& q, const std::string& file)
+    {
+        m_ids.push_back(std::string());
+        std::string& id = m_ids.back();
+        long long c = m_chunk_size;
+        unsigned p = m_parallel;
+        long long size = get_file_size(file);
+        bool whole = c < 0 ? chunk_sizer::get().plan(size, p).size() < 2
+            : c == 0 || size <= c;
+        if (whole) {
+            q.push(new attach_transfer(m_engine, m_url, file, m_report_level, id));
+            return;
+        }
+        m_uploads.push_back(base::shared_ptr<chunked_upload>(
+                    new chunked_upload(q, id)));
+        chunked_upload& u = *m_uploads.back();
+        if (c < 0) {
+            u.add(new chunk_transfer(m_engine, m_url, file, size, p,
+                        m_report_level, u));
+            return;
+        }
+        int n = static_cast<int>((size + c - 1) / c);
+        for (int k = 1; k <= n; ++k) {
+            long long o = (k - 1) * c;
+            transfer* t = new chunk_transfer(m_engine, m_url, file, k, n, o,
+                    std::min(c, size - o), m_report_level, u);
+            if (k == n) {
+                u.set_last(t);
+            } else {
+                u.add(t);
+            }
+        }
+    }
+
+    virtual bool feed(transfer_queue& q)
+    {
+        std::string f;
+        while (m_scanner.next(f)) {
+            add(q, f);
+        }
+        return !m_scanner.finished();
+    }
+
+    std::vector<std::string> ids() const
+    {
+        return std::vector<std::string>(m_ids.begin(), m_ids.end());
+    }
+
+private:
+    const engine& m_engine;
+    std::string m_url;
+    unsigned m_parallel;
+    long long m_chunk_size;
+    report_level m_report_level;
+    file_scanner& m_scanner;
+    // Uploads keep the references to their IDs, which stay valid in deque.
+    std::deque<std::string> m_ids;
+    std::vector<base::shared_ptr<chunked_upload> > m_uploads;
+};
+
+std::vector<std::string> engine::attach_impl(std::string server,
+        const strings& fs,
+        unsigned p,
+        long long c,
+        report_level s)
+{
+    server += "/attachments";
+    context& x = m_context.get();
+    file_scanner fsc(x.m_include, x.m_exclude);
+    upload_source u(*this, server, p, c, s, fsc);
+    transfer_queue q(m_pool, handle(), p);
+    std::vector<std::string> ds;
+    for (strings::const_iterator i = fs.begin(); i != fs.end(); ++i) {
+        if (file_scanner::is_directory(*i)) {
+            ds.push_back(*i);
+        } else {
+            u.add(q, *i);
+        }
+    }
+    if (!ds.empty()) {
+        if (s >= NORMAL) {
+            for (std::vector<std::string>::iterator i = ds.begin(); i != ds.end(); ++i) {
+                io::mout << "Scanning directory '" << *i << "'." << io::endl;
+            }
+        }
+        fsc.start(ds);
+        q.set_source(&u);
+    }
+    q.run();
+    return u.ids();
+}
+
 std::string engine::send_attachments_impl(std::string server,
         const std::string& user,
         const std::string& subject,
@@ -571,8 +1510,8 @@ std::string engine::send_attachments_impl(std::string server,
         report_level s)
 {
     server += "/message";
-    curl_easy_setopt(m_curl, CURLOPT_URL, server.c_str());
-    curl_header_guard hg(m_curl);
+    curl_easy_setopt(handle(), CURLOPT_URL, server.c_str());
+    curl_header_guard hg(handle());
     std::string data = std::string(
 "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\
   <message>\
@@ -592,8 +1531,7 @@ std::string engine::send_attachments_impl(std::string server,
     }
     data += "    </attachments>\
   </message>\n";
-    curl_easy_setopt(m_curl, CURLOPT_HTTPPOST, 0);
-    curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS, data.c_str());
+    curl_easy_setopt(handle(), CURLOPT_POSTFIELDS, data.c_str());
     if (s >= NORMAL) {
         io::mout << "Sending message to user '" << user << "'" << io::endl;
     }
@@ -604,8 +1542,8 @@ std::string engine::filelink_impl(std::string server, const std::string& expire,
             const std::string& id, report_level s)
 {
     server += "/link";
-    curl_easy_setopt(m_curl, CURLOPT_URL, server.c_str());
-    curl_header_guard hg(m_curl);
+    curl_easy_setopt(handle(), CURLOPT_URL, server.c_str());
+    curl_header_guard hg(handle());
     std::string data = std::string(
 "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\
   <link>\
@@ -614,8 +1552,7 @@ std::string engine::filelink_impl(std::string server, const std::string& expire,
         data += std::string("<expires_at>") + expire + "</expires_at>\n";
     }
     data += "  </link>\n";
-    curl_easy_setopt(m_curl, CURLOPT_HTTPPOST, 0);
-    curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS, data.c_str());
+    curl_easy_setopt(handle(), CURLOPT_POSTFIELDS, data.c_str());
     if (s >= NORMAL) {
         io::mout << "Creating filelink" << io::endl;
     }
@@ -653,34 +1590,22 @@ void engine::process_attach_responce(const std::string& r, report_level s) const
 std::string engine::process_send_responce(const std::string& r,
         report_level s) const
 {
-    xml::document<> d;
-    d.parse<xml::parse_fastest | xml::parse_no_utf8>(const_cast<char*>(r.c_str()));
-    xml::node_iterator<> i(d.first_node());
-    xml::node_iterator<> e;
-    while(i != e) {
-        std::string n(i->name(), i->name_size());
-        if (n == "id") {
-            std::string v(i->value(), i->value_size());
-            if (s >= NORMAL) {
-                io::mout << "Message sent successfully. ID: " << v << io::endl;
-            }
-            return v;
-        }
-        ++i;
+    std::string v = extract_field<id_tag>(r, "send", true);
+    if (s >= NORMAL) {
+        io::mout << "Message sent successfully. ID: " << v << io::endl;
     }
-    throw request_error("send", r);
-    return "";
+    return v;
 }
 
 template <typename T>
 void engine::process_output_responce(const std::string& r,
         report_level s, output_format f) const
 {
-    xml::document<> d;
-    d.parse<xml::parse_fastest | xml::parse_no_utf8>(const_cast<char*>(r.c_str()));
+    xml::document<>& d = parse(document(), r);
     T m;
     m.read(&d);
-    io::mout << m.to_string(f);
+    io::output_sink o(io::mout.stream());
+    m.write(o, f);
 }
 
 std::string engine::message_impl(std::string server, const std::string& key,
@@ -689,16 +1614,16 @@ std::string engine::message_impl(std::string server, const std::string& key,
     init_curl(key, s, v);
     server += "/message/";
     server += id;
-    curl_easy_setopt(m_curl, CURLOPT_URL, server.c_str());
-    curl_header_guard hg(m_curl);
+    curl_easy_setopt(handle(), CURLOPT_URL, server.c_str());
+    curl_header_guard hg(handle());
     if (s >= NORMAL) {
         io::mout << log << io::endl;
     }
     return perform();
 }
 
-std::string engine::messages_impl(std::string server, const std::string& key, std::string l,
-        std::string f, report_level s, validate_cert v)
+void engine::messages_impl(std::string server, const std::string& key, std::string l,
+        std::string f, report_level s, validate_cert v, xml::stream_parser& p)
 {
     init_curl(key, s, v);
     server += "/message";
@@ -709,77 +1634,109 @@ std::string engine::messages_impl(std::string server, const std::string& key, st
         server += "?sent_after=";
         server += f;
     }
-    curl_easy_setopt(m_curl, CURLOPT_URL, server.c_str());
-    curl_header_guard hg(m_curl);
+    curl_easy_setopt(handle(), CURLOPT_URL, server.c_str());
+    curl_header_guard hg(handle());
     if (s >= NORMAL) {
         io::mout << "Getting messages from the server." << io::endl;
     }
-    return perform();
+    perform(p);
 }
 
 void engine::download_impl(const std::string& url,
         const std::string& path,
         std::string name,
+        long long size,
+        unsigned n,
+        const integrity_check& c,
         report_level s)
 {
-    if (s >= NORMAL) {
-        io::mout << "Downloading file '" << name << "'" << io::endl;
+    std::string file = path.empty() ? name : path + "/" + name;
+    std::string part = file + ".part";
+    if (n > 1 && (get_file_size(part) < 0 || segmented_download::resumable(part))) {
+        if (s >= NORMAL) {
+            io::mout << "Downloading file '" << name << "'" << io::endl;
+        }
+        if (download_segments(url, file, size, n, c, s)) {
+            promote_file(part, file);
+            segmented_download::discard(part);
+            return;
+        }
     }
-    if (!path.empty()) {
-        name = path + "/" + name;
+    transfer_queue q(m_pool, handle(), 1);
+    q.push(new download_transfer(url, path, name, size, c, s, 0));
+    q.run();
+}
+
+bool engine::download_segments(const std::string& url,
+        const std::string& file,
+        long long size,
+        unsigned n,
+        const integrity_check& c,
+        report_level s)
+{
+    if (size < 0) {
+        curl_easy_setopt(handle(), CURLOPT_URL, url.c_str());
+        curl_easy_setopt(handle(), CURLOPT_NOBODY, 1L);
+        curl_easy_setopt(handle(), CURLOPT_FAILONERROR, 1L);
+        try {
+            perform();
+        } catch (curl_error&) {
+        }
+        curl_off_t l = -1;
+        curl_easy_getinfo(handle(), CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &l);
+        curl_easy_setopt(handle(), CURLOPT_FAILONERROR, 0L);
+        curl_easy_setopt(handle(), CURLOPT_HTTPGET, 1L);
+        size = l;
+    }
+    std::string part = file + ".part";
+    if (size < s_segmented_download_size) {
+        segmented_download::discard(part);
+        return false;
+    }
+    // Other errors keep the finished segments to resume from.
+    try {
+        segmented_download d(m_pool, handle(), url, part, size, n,
+                c.enabled() && !c.sha256_enabled());
+        if (s >= NORMAL) {
+            if (d.resumed() > 0) {
+                io::mout << "Resuming from " << d.resumed()
+                    << " bytes of finished segments." << io::endl;
+            }
+            io::mout << "Downloading by " << std::min(n, d.s_max_host_connections)
+                << " connections." << io::endl;
+        }
+        if (d.run()) {
+            integrity_check k(c);
+            if (k.sha256_enabled()) {
+                k.update_file(part, size);
+            } else {
+                k.set_crc32(d.crc32(), size);
+            }
+            k.verify(file);
+            return true;
+        }
+    } catch (download_error&) {
+        segmented_download::discard(part);
+        throw;
     }
-    FILE* fp = fopen(name.c_str(), "wb");
-    if (fp == 0) {
-        throw file_error(name, strerror(errno));
+    segmented_download::discard(part);
+    if (s >= NORMAL) {
+        io::mout << "Server does not support byte ranges, downloading by one connection." << io::endl;
     }
-    curl_file_guard fg(m_curl, fp);
-    curl_easy_setopt(m_curl, CURLOPT_URL, url.c_str());
-    perform();
+    return false;
 }
 
 std::string engine::get_filedrop_api_key(const std::string& url, report_level s, validate_cert v)
 {
     init_curl("", s, v);
-    curl_easy_setopt(m_curl, CURLOPT_URL, url.c_str());
-    curl_header_guard hg(m_curl);
+    curl_easy_setopt(handle(), CURLOPT_URL, url.c_str());
+    curl_header_guard hg(handle());
     if (s >= VERBOSE) {
         io::mout << "Getting filedrop API key" << io::endl;
     }
-    std::string r = perform();
-    xml::document<> d;
-    d.parse<xml::parse_fastest | xml::parse_no_utf8>(const_cast<char*>(r.c_str()));
-    if (d.first_node() == 0) {
-        throw request_error("filedrop info", r);
-    }
-    std::string h(d.first_node()->name(), d.first_node()->name_size());
-    xml::node_iterator<> i(d.first_node());
-    xml::node_iterator<> e;
-    if (h == "error") {
-        while(i != e) {
-            std::string n(i->name(), i->name_size());
-            if (n == "message") {
-                std::string m = std::string(i->value(), i->value_size());
-                throw request_error("filedrop info", m);
-                break;
-            }
-            ++i;
-        }
-        throw request_error("filedrop info", r);
-    }
-    std::string q;
-    while(i != e) {
-        std::string n(i->name(), i->name_size());
-        if (n == "api_key") {
-            q = std::string(i->value(), i->value_size());
-            if (s >= VERBOSE) {
-                io::mout << "Got filedrop API key: " << q << io::endl;
-            }
-            break;
-        }
-        ++i;
-    }
-    if (q.empty()) {
-        throw request_error("filedrop info", r);
+    std::string q = extract_field<api_key_tag>(perform(), "filedrop info");
+    if (s >= VERBOSE) {
+        io::mout << "Got filedrop API key: " << q << io::endl;
     }
     return q;
 }
@@ -788,8 +1745,8 @@ void engine::filedrop_attachments_impl(std::string server, const std::string& ke
         const std::string& user, const std::string& subject,
         const std::string& message, const strings& fs, report_level s)
 {
-    curl_easy_setopt(m_curl, CURLOPT_URL, server.c_str());
-    curl_header_guard hg(m_curl);
+    curl_easy_setopt(handle(), CURLOPT_URL, server.c_str());
+    curl_header_guard hg(handle());
     std::string data = std::string(
 "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\
   <message>\
@@ -806,8 +1763,7 @@ void engine::filedrop_attachments_impl(std::string server, const std::string& ke
     }
     data += "    </attachments>\
   </message>\n";
-    curl_easy_setopt(m_curl, CURLOPT_HTTPPOST, 0);
-    curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS, data.c_str());
+    curl_easy_setopt(handle(), CURLOPT_POSTFIELDS, data.c_str());
     if (s >= NORMAL) {
         io::mout << "Sending message to filedrop" << io::endl;
     }
@@ -816,133 +1772,99 @@ void engine::filedrop_attachments_impl(std::string server, const std::string& ke
 
 std::string engine::process_file_request_responce(const std::string& r, report_level s) const
 {
-    xml::document<> d;
-    d.parse<xml::parse_fastest | xml::parse_no_utf8>(const_cast<char*>(r.c_str()));
-
-    xml::node_iterator<> i(d.first_node());
-    xml::node_iterator<> e;
-    std::string q;
-    while(i != e) {
-        std::string n(i->name(), i->name_size());
-        if (n == "url") {
-            q = std::string(i->value(), i->value_size());
-            if (s >= NORMAL) {
-                    io::mout << "Request sent successfully. URL: " << q << io::endl;
-            }
-            break;
-        }
-        ++i;
-    }
-    if (q.empty()) {
-        throw request_error("file_request", r);
+    std::string q = extract_field<url_tag>(r, "file_request");
+    if (s >= NORMAL) {
+        io::mout << "Request sent successfully. URL: " << q << io::endl;
     }
     return q;
 }
 
 std::string engine::process_get_api_key_responce(const std::string& r, report_level s) const
 {
-    xml::document<> d;
-    d.parse<xml::parse_fastest | xml::parse_no_utf8>(const_cast<char*>(r.c_str()));
-    if (d.first_node() == 0) {
-        throw request_error("get_api_key", r);
-    }
-    std::string h(d.first_node()->name(), d.first_node()->name_size());
-    xml::node_iterator<> i(d.first_node());
-    xml::node_iterator<> e;
-    if (h == "error") {
-        while(i != e) {
-            std::string n(i->name(), i->name_size());
-            if (n == "message") {
-                std::string m = std::string(i->value(), i->value_size());
-                throw request_error("get_api_key", m);
-                break;
-            }
-            ++i;
-        }
-        throw request_error("get_api_key", r);
-    }
-    std::string q;
-    while(i != e) {
-        std::string n(i->name(), i->name_size());
-        if (n == "api_key") {
-            q = std::string(i->value(), i->value_size());
-            if (s >= NORMAL) {
-                io::mout << "Retrieved API key: " << q << io::endl;
-            }
-            break;
-        }
-        ++i;
-    }
-    if (q.empty()) {
-        throw request_error("get_api_key", r);
+    std::string q = extract_field<api_key_tag>(r, "get_api_key");
+    if (s >= NORMAL) {
+        io::mout << "Retrieved API key: " << q << io::endl;
     }
     return q;
 }
 
 std::string engine::process_create_filelink_responce(const std::string& r, report_level s) const
 {
-    xml::document<> d;
-    d.parse<xml::parse_fastest | xml::parse_no_utf8>(const_cast<char*>(r.c_str()));
-    if (d.first_node() == 0) {
-        throw request_error("create_filelink", r);
-    }
-    std::string h(d.first_node()->name(), d.first_node()->name_size());
-    xml::node_iterator<> i(d.first_node());
-    xml::node_iterator<> e;
-    std::string q;
-    while(i != e) {
-        std::string n(i->name(), i->name_size());
-        if (n == "url") {
-            q = std::string(i->value(), i->value_size());
-            if (s >= NORMAL) {
-                io::mout << "Created filelink sucessfully. URL: " << q << io::endl;
-            }
-            break;
-        }
-        ++i;
-    }
-    if (q.empty()) {
-        throw request_error("create_filelink", r);
+    std::string q = extract_field<url_tag>(r, "create_filelink");
+    if (s >= NORMAL) {
+        io::mout << "Created filelink sucessfully. URL: " << q << io::endl;
     }
     return q;
 }
 
 void engine::process_filedrop_responce(const std::string& r, report_level s) const
 {
-    xml::document<> d;
-    d.parse<xml::parse_fastest | xml::parse_no_utf8>(const_cast<char*>(r.c_str()));
-    if (d.first_node() == 0) {
-        throw request_error("filedrop", r);
-    }
-    std::string h(d.first_node()->name(), d.first_node()->name_size());
-    xml::node_iterator<> i(d.first_node());
-    xml::node_iterator<> e;
-    std::string q;
-    while(i != e) {
-        std::string n(i->name(), i->name_size());
-        if (n == "status") {
-            q = std::string(i->value(), i->value_size());
-            if (s >= NORMAL) {
-                io::mout << q << io::endl;
-            }
+    std::string q = extract_field<status_tag>(r, "filedrop");
+    if (s >= NORMAL) {
+        io::mout << q << io::endl;
+    }
+}
+
+std::string engine::perform(bool replayable)
+{
+    context& x = m_context.get();
+    CURLcode res = CURLE_OK;
+    for (unsigned a = 1; ; ++a) {
+        res = transfer_queue::perform(x.m_curl);
+        m_pool.account(x.m_curl, res, x.m_responce.data().size());
+        if (!retry_policy::get().replay(x.m_curl, res, a, replayable)) {
             break;
         }
-        ++i;
+        backoff(a);
+        x.m_responce.clear();
     }
-    if (q.empty()) {
-        throw request_error("filedrop", r);
+    std::string r;
+    x.m_responce.take(r);
+    if (res != CURLE_OK) {
+        throw curl_error(std::string(curl_easy_strerror(res)));
     }
+    return r;
 }
 
-std::string engine::perform()
+void engine::perform(xml::stream_parser& p)
 {
-    CURLcode res = curl_easy_perform(m_curl);
-    if (res != CURLE_OK) {
+    context& x = m_context.get();
+    curl_easy_setopt(x.m_curl, CURLOPT_WRITEFUNCTION, &data_parse);
+    curl_easy_setopt(x.m_curl, CURLOPT_WRITEDATA, &p);
+    CURLcode res = CURLE_OK;
+    for (unsigned a = 1; ; ++a) {
+        res = transfer_queue::perform(x.m_curl);
+        m_pool.account(x.m_curl, res, p.size());
+        // Printed elements would be printed again. Error page, which
+        // aborted the parser, is judged by its status.
+        CURLcode r = p.failed() ? CURLE_OK : res;
+        if (p.count() != 0 || !retry_policy::get().replay(x.m_curl, r, a)) {
+            break;
+        }
+        backoff(a);
+        p.reset();
+    }
+    x.m_responce.attach(x.m_curl);
+    if (res != CURLE_OK && !p.failed()) {
         throw curl_error(std::string(curl_easy_strerror(res)));
     }
-    std::string r = s_data;
-    s_data.clear();
-    return r;
+    p.finish();
+}
+
+void engine::backoff(unsigned a)
+{
+    context& x = m_context.get();
+    curl_off_t r = 0;
+    curl_easy_getinfo(x.m_curl, CURLINFO_RETRY_AFTER, &r);
+    long d = retry_policy::get().backoff(a, r);
+    if (x.m_report_level >= NORMAL) {
+        io::mout << "Request failed, retrying in " << d << " ms." << io::endl;
+    }
+    struct timespec t;
+    t.tv_sec = d / 1000;
+    t.tv_nsec = d % 1000 * 1000000;
+    while (nanosleep(&t, &t) != 0 && errno == EINTR) {
+    }
 }
 
 }
@@ -1,21 +1,35 @@
 #pragma once
 
+#include "connection_pool.h"
 #include "declarations.h"
 
+#include <base/mutex.h>
+#include <base/thread.h>
+
 #include <curl/curl.h>
 
 #include <set>
 #include <string>
+#include <vector>
+
+namespace xml {
+template <class Ch> class document;
+class stream_parser;
+}
 
 namespace lf {
 
+class integrity_check;
+
 /**
  * @class engine
  * @brief API for liquidfiles.
  *
  *        engine is main class to do operations with liquidfiles.
  *        It provides interface to send, receive files and other operations
- *        supported by liquidfiles.
+ *        supported by liquidfiles. Operations may be called from several
+ *        threads at once, every thread uses its own handle and response
+ *        buffer, while connections are shared by all of them.
  */
 class engine
 {
@@ -43,7 +57,11 @@ public:
      * @param user User name or email.
      * @param subject Subject of composed email.
      * @param message Message body of email.
-     * @param fs Files list to send.
+     * @param fs Files and directories to send.
+     * @param p Count of files to upload simultaneously.
+     * @param c Size of chunks to upload larger files by chunks,
+     *        0 to upload files as a whole, negative to pick the size by
+     *        measured throughput.
      * @param s Silence flag.
      * @param v Validate certificate flag for HTTP request.
      * @throw curl_error, request_error.
@@ -54,6 +72,8 @@ public:
             const std::string& subject,
             const std::string& message,
             const strings& fs,
+            unsigned p,
+            long long c,
             report_level s,
             validate_cert v);
 
@@ -82,7 +102,11 @@ public:
      * @brief Uploads given files to server.
      * @param server Server URL.
      * @param key API Key of Liquidfiles.
-     * @param fs Files list to send.
+     * @param fs Files and directories to send.
+     * @param p Count of files to upload simultaneously.
+     * @param c Size of chunks to upload larger files by chunks,
+     *        0 to upload files as a whole, negative to pick the size by
+     *        measured throughput.
      * @param s Silence flag.
      * @param v Validate certificate flag for HTTP request.
      * @throw curl_error, request_error.
@@ -90,6 +114,8 @@ public:
     void attach(std::string server,
             const std::string& key,
             const strings& fs,
+            unsigned p,
+            long long c,
             report_level s,
             validate_cert v);
 
@@ -155,6 +181,8 @@ public:
      * @param urls URLs of the files.
      * @param path Path to output directory.
      * @param key API Key of Liquidfiles.
+     * @param n Count of connections to download a large file by.
+     * @param p Count of files to download simultaneously.
      * @param s Silence flag.
      * @param v Validate certificate flag for HTTP request.
      * @throw file_error, curl_error, invalid_url.
@@ -162,6 +190,8 @@ public:
     void download(const std::set<std::string>& urls,
             const std::string& key,
             const std::string& path,
+            unsigned n,
+            unsigned p,
             report_level s,
             validate_cert v);
 
@@ -171,6 +201,8 @@ public:
      * @param path Path to output directory.
      * @param key API Key of Liquidfiles.
      * @param id Message id.
+     * @param n Count of connections to download a large file by.
+     * @param p Count of files to download simultaneously.
      * @param s Silence flag.
      * @param v Validate certificate flag for HTTP request.
      * @throw curl_error, file_error, invalid_message_id, invalid_url.
@@ -179,6 +211,8 @@ public:
             const std::string& key,
             const std::string& path,
             const std::string& id,
+            unsigned n,
+            unsigned p,
             report_level s,
             validate_cert v);
 
@@ -189,6 +223,8 @@ public:
      * @param key API Key of Liquidfiles.
      * @param l Hours, to get messages from the last specified hours.
      * @param f Date, to get messages from that date.
+     * @param n Count of connections to download a large file by.
+     * @param p Count of files to download simultaneously.
      * @param s Silence flag.
      * @param v Validate certificate flag for HTTP request.
      * @throw curl_error, file_error, invalid_url.
@@ -198,6 +234,8 @@ public:
             const std::string& path,
             const std::string& l,
             const std::string& f,
+            unsigned n,
+            unsigned p,
             report_level s,
             validate_cert v);
 
@@ -334,7 +372,11 @@ public:
      * @param user User name or email.
      * @param subject Subject of composed email.
      * @param message Message body of email.
-     * @param fs Files list to send.
+     * @param fs Files and directories to send.
+     * @param p Count of files to upload simultaneously.
+     * @param c Size of chunks to upload larger files by chunks,
+     *        0 to upload files as a whole, negative to pick the size by
+     *        measured throughput.
      * @param s Silence flag.
      * @param v Validate certificate flag for HTTP request.
      * @throw curl_error, request_error.
@@ -344,6 +386,8 @@ public:
             const std::string& subject,
             const std::string& message,
             const strings& fs,
+            unsigned p,
+            long long c,
             report_level s,
             validate_cert v);
 
@@ -367,9 +411,54 @@ public:
             validate_cert v);
     /// @}
 
+public:
+    /**
+     * @brief Sets the size of buffer to read uploaded files by, for the
+     *        operations called by this thread.
+     * @param n Size in bytes, curl accepts sizes from 16K to 2M.
+     */
+    void set_upload_buffer_size(long n);
+
+    /**
+     * @brief Sets the version of HTTP for the operations called by this
+     *        thread.
+     * @param v HTTP_2 negotiates HTTP/2 with servers, which support it over
+     *        TLS, and falls back to HTTP/1.1 with others.
+     */
+    void set_http_version(http_version v);
+
+    /**
+     * @brief Sets the patterns of files to upload from the directories,
+     *        which are given to the operations called by this thread.
+     *
+     *        Directories are uploaded with all their subdirectories.
+     *        Patterns are shell wildcards, which are matched against the
+     *        name, or against the path in directory if they have '/'.
+     * @param include Patterns of files to upload, all files if empty.
+     * @param exclude Patterns of files and directories to skip.
+     */
+    void set_file_patterns(const std::vector<std::string>& include,
+            const std::vector<std::string>& exclude);
+
+public:
+    /**
+     * @brief Prints the counters of requests, connections and retries, if
+     *        the last operation was run with verbose report level.
+     */
+    void report_statistics();
+
 private:
+    class attach_transfer;
+    class chunk_transfer;
+    class download_transfer;
+    class download_pipeline;
+    class message_transfer;
+    class upload_source;
+
     std::string attach_impl(std::string server, const std::string& file,
             report_level s);
+    std::vector<std::string> attach_impl(std::string server, const strings& fs,
+            unsigned p, long long c, report_level s);
     std::string send_attachments_impl(std::string server, const std::string& user,
             const std::string& subject, const std::string& message,
             const strings& fs, report_level s);
@@ -378,9 +467,12 @@ private:
     void init_curl(std::string key, report_level s, validate_cert v);
     std::string message_impl(std::string server, const std::string& key, std::string id,
             report_level s, validate_cert v, std::string log);
-    std::string messages_impl(std::string server, const std::string& key, std::string l,
-            std::string f, report_level s, validate_cert v);
-    void download_impl(const std::string& url, const std::string& path, std::string name, report_level s);
+    void messages_impl(std::string server, const std::string& key, std::string l,
+            std::string f, report_level s, validate_cert v, xml::stream_parser& p);
+    void download_impl(const std::string& url, const std::string& path, std::string name,
+            long long size, unsigned n, const integrity_check& c, report_level s);
+    bool download_segments(const std::string& url, const std::string& file,
+            long long size, unsigned n, const integrity_check& c, report_level s);
     std::string get_filedrop_api_key(const std::string& url, report_level s, validate_cert v);
     void filedrop_attachments_impl(std::string server, const std::string& key,
             const std::string& user, const std::string& subject,
@@ -398,10 +490,21 @@ private:
     template <typename T>
     void process_output_responce(const std::string& r, report_level s, output_format f) const;
 
-    std::string perform();
+    std::string perform(bool replayable = false);
+    void perform(xml::stream_parser& p);
+    void backoff(unsigned a);
+    CURL* handle();
+
+    /// Document of calling thread to parse responces into.
+    xml::document<char>& document() const;
 
 private:
-    CURL* m_curl;
+    struct context;
+
+    connection_pool m_pool;
+    mutable base::thread_specific<context> m_context;
+    base::mutex m_mutex;
+    report_level m_report_level;
 };
 
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <base/exception.h>
+#include <base/string.h>
 
 #include <string>
 
@@ -33,6 +34,25 @@ public:
     }
 };
 
+class download_error : public base::exception
+{
+public:
+    download_error(const std::string& f, const std::string& e)
+        : base::exception(std::string("Download of file '") + f + "' failed. " + e, 6)
+    {
+    }
+};
+
+class incomplete_download : public base::exception
+{
+public:
+    incomplete_download(unsigned n, unsigned t)
+        : base::exception(base::to_string(n) + " of " + base::to_string(t)
+                + " files are not downloaded.", 6)
+    {
+    }
+};
+
 class invalid_message_id : public base::exception
 {
 public:
@@ -0,0 +1,315 @@
+#include "file_scanner.h"
+
+#include <base/thread.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <stdint.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace lf {
+
+namespace {
+
+/// Size of buffer to read directory entries by.
+const size_t s_listing_size = 32 * 1024;
+
+/// Reads the entries of open directory.
+class listing
+{
+public:
+    listing(int fd)
+        : m_fd(fd)
+#ifdef SYS_getdents64
+        , m_buffer(s_listing_size)
+        , m_size(0)
+        , m_position(0)
+#else
+        , m_dir(fdopendir(dup(fd)))
+#endif
+    {
+    }
+
+    ~listing()
+    {
+#ifndef SYS_getdents64
+        if (m_dir != 0) {
+            closedir(m_dir);
+        }
+#endif
+    }
+
+private:
+    listing(const listing&);
+    listing& operator=(const listing&);
+
+public:
+    /// Gets the next entry, its type is DT_UNKNOWN if it is not listed.
+    bool next(const char*& n, unsigned char& t)
+    {
+#ifdef SYS_getdents64
+        if (m_position >= m_size) {
+            m_size = syscall(SYS_getdents64, m_fd, &m_buffer[0], m_buffer.size());
+            m_position = 0;
+            if (m_size <= 0) {
+                return false;
+            }
+        }
+        const entry* e = reinterpret_cast<const entry*>(&m_buffer[m_position]);
+        m_position += e->d_reclen;
+        n = e->d_name;
+        t = e->d_type;
+        return true;
+#else
+        struct dirent* e = m_dir == 0 ? 0 : readdir(m_dir);
+        if (e == 0) {
+            return false;
+        }
+        n = e->d_name;
+        t = DT_UNKNOWN;
+        return true;
+#endif
+    }
+
+private:
+#ifdef SYS_getdents64
+    struct entry
+    {
+        uint64_t d_ino;
+        int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[1];
+    };
+
+    int m_fd;
+    std::vector<char> m_buffer;
+    long m_size;
+    long m_position;
+#else
+    int m_fd;
+    DIR* m_dir;
+#endif
+};
+
+bool matches(const std::vector<std::string>& ps, const char* n,
+        const std::string& r)
+{
+    for (std::vector<std::string>::const_iterator i = ps.begin(); i != ps.end(); ++i) {
+        bool path = i->find('/') != std::string::npos;
+        if (fnmatch(i->c_str(), path ? r.c_str() : n, path ? FNM_PATHNAME : 0) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+/// Open directory, which is shared by the reader and its queued children.
+struct file_scanner::descriptor
+{
+    descriptor(int fd)
+        : m_fd(fd)
+        , m_users(1)
+    {
+    }
+
+    int m_fd;
+    unsigned m_users;
+};
+
+class file_scanner::worker : public base::thread
+{
+public:
+    worker(file_scanner& s)
+        : m_scanner(s)
+    {
+    }
+
+protected:
+    virtual void run()
+    {
+        m_scanner.work();
+    }
+
+private:
+    file_scanner& m_scanner;
+};
+
+const unsigned file_scanner::s_threads;
+
+file_scanner::file_scanner(const patterns& include, const patterns& exclude)
+    : m_include(include)
+    , m_exclude(exclude)
+    , m_busy(0)
+    , m_stopped(false)
+    , m_error(0)
+{
+}
+
+file_scanner::~file_scanner()
+{
+    {
+        base::scoped_lock l(m_mutex);
+        m_stopped = true;
+        m_condition.broadcast();
+    }
+    for (std::vector<worker*>::iterator i = m_workers.begin(); i != m_workers.end(); ++i) {
+        delete *i;
+    }
+    while (!m_directories.empty()) {
+        release(m_directories.back().m_parent);
+        m_directories.pop_back();
+    }
+    delete m_error;
+}
+
+bool file_scanner::is_directory(const std::string& p)
+{
+    struct stat sb;
+    return stat(p.c_str(), &sb) == 0 && S_ISDIR(sb.st_mode);
+}
+
+void file_scanner::start(const std::vector<std::string>& ds)
+{
+    {
+        base::scoped_lock l(m_mutex);
+        for (std::vector<std::string>::const_iterator i = ds.begin(); i != ds.end(); ++i) {
+            std::string p = *i;
+            while (p.size() > 1 && p[p.size() - 1] == '/') {
+                p.erase(p.size() - 1);
+            }
+            m_directories.push_back(directory(0, p, p, ""));
+        }
+    }
+    for (unsigned i = 0; i < s_threads; ++i) {
+        m_workers.push_back(new worker(*this));
+        if (!m_workers.back()->start()) {
+            throw file_error(ds.front(), "Failed to start threads of scan.");
+        }
+    }
+}
+
+bool file_scanner::next(std::string& f)
+{
+    base::scoped_lock l(m_mutex);
+    if (m_error != 0) {
+        throw *m_error;
+    }
+    if (m_files.empty()) {
+        return false;
+    }
+    f.swap(m_files.front());
+    m_files.pop_front();
+    return true;
+}
+
+bool file_scanner::finished()
+{
+    base::scoped_lock l(m_mutex);
+    return m_files.empty() && m_directories.empty() && m_busy == 0
+        && m_error == 0;
+}
+
+void file_scanner::work()
+{
+    base::scoped_lock l(m_mutex);
+    while (true) {
+        while (!m_stopped && m_directories.empty() && m_busy != 0) {
+            m_condition.wait(m_mutex);
+        }
+        if (m_stopped || m_directories.empty()) {
+            m_condition.broadcast();
+            return;
+        }
+        // Directories are taken depth first, so only the directories on
+        // the current paths are kept open.
+        directory d = m_directories.back();
+        m_directories.pop_back();
+        ++m_busy;
+        m_mutex.unlock();
+        scan(d);
+        m_mutex.lock();
+        --m_busy;
+        if (m_busy == 0 && m_directories.empty()) {
+            m_condition.broadcast();
+        }
+    }
+}
+
+void file_scanner::scan(const directory& d)
+{
+    int fd = d.m_parent == 0
+        ? open(d.m_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)
+        : openat(d.m_parent->m_fd, d.m_name.c_str(),
+                O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    int e = errno;
+    {
+        base::scoped_lock l(m_mutex);
+        release(d.m_parent);
+        if (fd < 0 && m_error == 0) {
+            m_error = new file_error(d.m_path, std::strerror(e));
+            m_stopped = true;
+            m_condition.broadcast();
+        }
+    }
+    if (fd < 0) {
+        return;
+    }
+    descriptor* self = new descriptor(fd);
+    std::vector<directory> ds;
+    std::deque<std::string> fs;
+    std::string prefix = d.m_path == "/" ? d.m_path : d.m_path + "/";
+    listing x(fd);
+    const char* name = 0;
+    unsigned char t = DT_UNKNOWN;
+    while (x.next(name, t)) {
+        if (std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0) {
+            continue;
+        }
+        if (t == DT_UNKNOWN || t == DT_LNK) {
+            struct stat sb;
+            if (fstatat(fd, name, &sb, t == DT_LNK ? 0 : AT_SYMLINK_NOFOLLOW) != 0) {
+                continue;
+            }
+            t = S_ISREG(sb.st_mode) ? DT_REG
+                : S_ISDIR(sb.st_mode) && t != DT_LNK ? DT_DIR : DT_UNKNOWN;
+        }
+        std::string r = d.m_relative + name;
+        if ((t != DT_REG && t != DT_DIR) || matches(m_exclude, name, r)) {
+            continue;
+        }
+        if (t == DT_DIR) {
+            ds.push_back(directory(self, name, prefix + name, r + "/"));
+        } else if (m_include.empty() || matches(m_include, name, r)) {
+            fs.push_back(prefix + name);
+        }
+    }
+    base::scoped_lock l(m_mutex);
+    m_files.insert(m_files.end(), fs.begin(), fs.end());
+    if (!m_stopped) {
+        self->m_users += ds.size();
+        // Reversed, so the first entries are read first.
+        m_directories.insert(m_directories.end(), ds.rbegin(), ds.rend());
+        m_condition.broadcast();
+    }
+    release(self);
+}
+
+void file_scanner::release(descriptor* d)
+{
+    if (d != 0 && --d->m_users == 0) {
+        close(d->m_fd);
+        delete d;
+    }
+}
+
+}
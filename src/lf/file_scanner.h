@@ -0,0 +1,115 @@
+#pragma once
+
+#include "exceptions.h"
+
+#include <base/mutex.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace lf {
+
+/**
+ * @class file_scanner
+ * @brief Finds the files of directory trees by several threads.
+ *
+ *        Directories are read by openat and getdents, and the entries,
+ *        which type is not known from the listing, by fstatat, so paths
+ *        are not resolved from the root again for every entry. Found files
+ *        are taken by the caller while the scan goes on. Symbolic links to
+ *        files are followed, symbolic links to directories are not, so the
+ *        scan does not loop.
+ *
+ *        Patterns are shell wildcards. Pattern with '/' is matched against
+ *        the path relative to the scanned directory, otherwise against the
+ *        name. Excluded directories are not entered. When include patterns
+ *        are given, only the files matching any of them are taken.
+ */
+class file_scanner
+{
+public:
+    typedef std::vector<std::string> patterns;
+
+    /// @brief Count of threads, which read directories.
+    static const unsigned s_threads = 4;
+
+public:
+    /**
+     * @brief Constructor.
+     * @param include Patterns of files to take, all files if empty.
+     * @param exclude Patterns of files and directories to skip.
+     */
+    file_scanner(const patterns& include, const patterns& exclude);
+
+    /// @brief Destructor, stops the scan.
+    ~file_scanner();
+
+private:
+    file_scanner(const file_scanner&);
+    file_scanner& operator=(const file_scanner&);
+
+public:
+    /// @brief Checks whether the path is a directory.
+    static bool is_directory(const std::string& p);
+
+    /**
+     * @brief Starts the scan of directories.
+     * @param ds Paths of directories.
+     * @throw file_error.
+     */
+    void start(const std::vector<std::string>& ds);
+
+    /**
+     * @brief Takes the next found file, without waiting.
+     * @param f Path of file.
+     * @return False if no file is found since the last call.
+     * @throw file_error, if a directory can't be read.
+     */
+    bool next(std::string& f);
+
+    /// @brief Checks whether the scan is over and all files are taken.
+    bool finished();
+
+private:
+    struct descriptor;
+    class worker;
+
+    /// Directory to read, it is opened relative to its parent.
+    struct directory
+    {
+        directory(descriptor* p, const std::string& n, const std::string& f,
+                const std::string& r)
+            : m_parent(p)
+            , m_name(n)
+            , m_path(f)
+            , m_relative(r)
+        {
+        }
+
+        descriptor* m_parent;
+        std::string m_name;
+        std::string m_path;
+        std::string m_relative;
+    };
+
+    void work();
+    void scan(const directory& d);
+    void release(descriptor* d);
+    bool excluded(const char* n, const std::string& r) const;
+    bool included(const char* n, const std::string& r) const;
+
+private:
+    patterns m_include;
+    patterns m_exclude;
+    base::mutex m_mutex;
+    base::condition m_condition;
+    std::deque<directory> m_directories;
+    std::deque<std::string> m_files;
+    unsigned m_busy;
+    bool m_stopped;
+    file_error* m_error;
+    std::vector<worker*> m_workers;
+};
+
+}
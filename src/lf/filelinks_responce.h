@@ -2,10 +2,12 @@
 
 #include "declarations.h"
 
-#include <xml/xml.h>
+#include <io/csv_stream.h>
+#include <io/table_printer.h>
+#include <xml/xml_stream.h>
 
+#include <iostream>
 #include <string>
-#include <vector>
 
 namespace lf {
 
@@ -13,22 +15,30 @@ namespace lf {
  * @class filelinks_responce
  * @brief Class for handling filelinks responce from server and printing
  *        it for user.
+ *
+ *        Filelinks are read one by one from xml::stream_parser and are
+ *        written to the output sink as soon as they are read, so printing
+ *        does not hold them in memory.
  */
-class filelinks_responce
+class filelinks_responce : public xml::element_handler
 {
 public:
     /**
-     * @brief Generates filelinks_responce from xml node.
-     * @param s Xml node.
+     * @brief Constructor.
+     * @param o Output sink, usually io::output_sink.
+     * @param f Output format.
      */
-    void read(xml::node<>* s);
+    filelinks_responce(std::ostream* o, output_format f);
 
 public:
     /**
-     * @brief Gets the string representation of responce.
-     * @param f Output format.
+     * @brief Reads the filelink element.
+     * @param s Xml node of filelink.
      */
-    std::string to_string(output_format f) const;
+    virtual void element(xml::node<>* s);
+
+    /// @brief Flushes the output sink after every part of responce.
+    virtual void flush();
 
 private:
     struct link_item {
@@ -40,20 +50,22 @@ private:
     };
 
 public:
-    typedef std::vector<link_item>::size_type size_type;
-
-    /// @brief Returns the count of filelinks.
-    size_type size() const
+    /// @brief Returns the count of printed filelinks.
+    unsigned size() const
     {
-        return m_links.size();
+        return m_count;
     }
 
 private:
-    void write_csv(std::stringstream&) const;
-    void write_table(std::stringstream&) const;
+    void write_csv(const link_item& j);
+    void write_table(const link_item& j);
 
 private:
-    std::vector<link_item> m_links;
+    std::ostream* m_output;
+    output_format m_format;
+    io::csv_ostream m_csv;
+    io::table_printer m_table;
+    unsigned m_count;
 };
 
 }
@@ -0,0 +1,129 @@
+#include "integrity_check.h"
+#include "crc32.h"
+#include "exceptions.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace lf {
+
+namespace {
+
+size_t s_read_buffer_size = 1024 * 1024;
+
+bool is_hex(const std::string& s)
+{
+    for (std::string::size_type i = 0; i < s.size(); ++i) {
+        if (!std::isxdigit(static_cast<unsigned char>(s[i]))) {
+            return false;
+        }
+    }
+    return !s.empty();
+}
+
+std::string to_lower(std::string s)
+{
+    for (std::string::size_type i = 0; i < s.size(); ++i) {
+        s[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(s[i])));
+    }
+    return s;
+}
+
+std::string to_hex(uint32_t c)
+{
+    char b[9];
+    std::sprintf(b, "%08x", c);
+    return b;
+}
+
+}
+
+integrity_check::integrity_check()
+    : m_expected_crc32(0)
+    , m_crc32_enabled(false)
+    , m_sha256_enabled(false)
+    , m_crc32(0)
+    , m_size(0)
+{
+}
+
+integrity_check::integrity_check(const std::string& crc32,
+        const std::string& checksum)
+    : m_expected_crc32(0)
+    , m_crc32_enabled(false)
+    , m_sha256_enabled(false)
+    , m_crc32(0)
+    , m_size(0)
+{
+    if (crc32.size() <= 8 && is_hex(crc32)) {
+        m_expected_crc32 = static_cast<uint32_t>(std::strtoul(crc32.c_str(), 0, 16));
+        m_crc32_enabled = true;
+    } else if (checksum.size() == 64 && is_hex(checksum)) {
+        m_expected_sha256 = to_lower(checksum);
+        m_sha256_enabled = true;
+    }
+}
+
+void integrity_check::reset()
+{
+    m_crc32 = 0;
+    m_sha256.reset();
+    m_size = 0;
+}
+
+void integrity_check::update(const char* d, size_t n)
+{
+    if (m_crc32_enabled) {
+        m_crc32 = crc32_update(m_crc32, d, n);
+    }
+    if (m_sha256_enabled) {
+        m_sha256.update(d, n);
+    }
+    m_size += n;
+}
+
+void integrity_check::update_file(const std::string& f, long long n)
+{
+    FILE* fp = std::fopen(f.c_str(), "rb");
+    if (fp == 0) {
+        throw file_error(f, std::strerror(errno));
+    }
+    std::vector<char> b(s_read_buffer_size);
+    while (n > 0) {
+        size_t k = std::fread(&b[0], 1, std::min<long long>(n, b.size()), fp);
+        if (k == 0) {
+            break;
+        }
+        update(&b[0], k);
+        n -= k;
+    }
+    std::fclose(fp);
+}
+
+void integrity_check::set_crc32(uint32_t c, long long n)
+{
+    m_crc32 = c;
+    m_size = n;
+}
+
+void integrity_check::verify(const std::string& f) const
+{
+    if (m_crc32_enabled && m_crc32 != m_expected_crc32) {
+        throw download_error(f, "CRC32 of downloaded data is " + to_hex(m_crc32)
+                + " instead of " + to_hex(m_expected_crc32) + ".");
+    }
+    if (m_sha256_enabled) {
+        std::string s = m_sha256.hex_digest();
+        if (s != m_expected_sha256) {
+            throw download_error(f, "Checksum of downloaded data is " + s
+                    + " instead of " + m_expected_sha256 + ".");
+        }
+    }
+}
+
+}
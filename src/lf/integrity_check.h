@@ -0,0 +1,93 @@
+#pragma once
+
+#include "sha256.h"
+
+#include <string>
+
+#include <stdint.h>
+
+namespace lf {
+
+/**
+ * @class integrity_check
+ * @brief Checks downloaded data against the checksums given by server.
+ *
+ *        Data is hashed while it is downloaded, so file is not read again.
+ *        CRC-32 is checked when server gives it, otherwise SHA-256 checksum
+ *        is checked. Without both of them nothing is checked.
+ */
+class integrity_check
+{
+public:
+    /// @brief Constructor for data without checksums.
+    integrity_check();
+
+    /**
+     * @brief Constructor.
+     * @param crc32 CRC-32 given by server, as hex string.
+     * @param checksum SHA-256 checksum given by server, as hex string.
+     */
+    integrity_check(const std::string& crc32, const std::string& checksum);
+
+public:
+    /// @brief Checks whether the data is hashed.
+    bool enabled() const
+    {
+        return m_crc32_enabled || m_sha256_enabled;
+    }
+
+    /// @brief Checks whether the data is hashed by SHA-256.
+    bool sha256_enabled() const
+    {
+        return m_sha256_enabled;
+    }
+
+    /// @brief Gets the count of hashed bytes.
+    long long size() const
+    {
+        return m_size;
+    }
+
+    /// @brief Starts hashing from the beginning of data.
+    void reset();
+
+    /**
+     * @brief Hashes the next bytes of data.
+     * @param d Data.
+     * @param n Size of data.
+     */
+    void update(const char* d, size_t n);
+
+    /**
+     * @brief Hashes the data, which is already in the file.
+     * @param f File path.
+     * @param n Count of bytes to read from the beginning of file.
+     * @throw file_error.
+     */
+    void update_file(const std::string& f, long long n);
+
+    /**
+     * @brief Sets CRC-32 of the whole data, which is computed elsewhere.
+     * @param c CRC-32.
+     * @param n Size of data.
+     */
+    void set_crc32(uint32_t c, long long n);
+
+    /**
+     * @brief Compares the hashes with the checksums given by server.
+     * @param f Name of file, to report.
+     * @throw download_error.
+     */
+    void verify(const std::string& f) const;
+
+private:
+    uint32_t m_expected_crc32;
+    std::string m_expected_sha256;
+    bool m_crc32_enabled;
+    bool m_sha256_enabled;
+    uint32_t m_crc32;
+    sha256 m_sha256;
+    long long m_size;
+};
+
+}
@@ -5,7 +5,6 @@
 #include <xml/xml_iterators.h>
 
 #include <cstdlib>
-#include <sstream>
 
 namespace lf {
 
@@ -89,9 +88,8 @@ void message_responce::read(xml::node<>* s)
     }
 }
 
-std::string message_responce::to_string(output_format f) const
+void message_responce::write(std::ostream& m, output_format f) const
 {
-    std::stringstream m;
     switch (f) {
     case TABLE_FORMAT:
         write_table(m);
@@ -101,10 +99,9 @@ std::string message_responce::to_string(output_format f) const
     default:
         break;
     }
-    return m.str();
 }
 
-void message_responce::write_table(std::stringstream& m) const
+void message_responce::write_table(std::ostream& m) const
 {
     m << "ID: " << m_id << "\n";
     m << "From: " << m_sender << "\n";
@@ -151,19 +148,13 @@ void message_responce::write_table(std::stringstream& m) const
         int x = 1;
         while (j != m_attachments.end()) {
             tp << x++;
-            std::stringstream ss((j++)->to_string(TABLE_FORMAT));
-            std::string s;
-            std::getline(ss, s);
-            tp << s;
-            while (std::getline(ss, s)) {
-                tp << " " << s;
-            }
+            (j++)->write(tp);
             tp.print_footer();
         }
     }
 }
 
-void message_responce::write_csv(std::stringstream& m) const
+void message_responce::write_csv(std::ostream& m) const
 {
     io::csv_ostream cp(&m);
     cp << m_id << m_sender;
@@ -188,7 +179,7 @@ void message_responce::write_csv(std::stringstream& m) const
     cp << m_attachments.size();
     std::vector<attachment_responce>::const_iterator j = m_attachments.begin();
     while (j != m_attachments.end()) {
-        m << ',' << (j++)->to_string(CSV_FORMAT);
+        (j++)->write(cp);
     }
 }
 
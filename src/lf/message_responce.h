@@ -5,6 +5,7 @@
 
 #include <xml/xml.h>
 
+#include <iostream>
 #include <string>
 #include <vector>
 
@@ -26,10 +27,11 @@ public:
 
 public:
     /**
-     * @brief Gets the string of responce to print.
-     * @param f Format of string.
+     * @brief Prints the responce.
+     * @param o Output sink, usually io::output_sink.
+     * @param f Output format.
      */
-    std::string to_string(output_format f) const;
+    void write(std::ostream& o, output_format f) const;
 
 public:
     /// @brief Access to ID.
@@ -105,8 +107,8 @@ public:
     }
 
 private:
-    void write_table(std::stringstream&) const;
-    void write_csv(std::stringstream&) const;
+    void write_table(std::ostream&) const;
+    void write_csv(std::ostream&) const;
 
 private:
     std::string m_id;
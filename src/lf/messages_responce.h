@@ -2,8 +2,11 @@
 
 #include "declarations.h"
 
-#include <xml/xml.h>
+#include <io/csv_stream.h>
+#include <io/table_printer.h>
+#include <xml/xml_stream.h>
 
+#include <iostream>
 #include <string>
 #include <vector>
 
@@ -13,22 +16,33 @@ namespace lf {
  * @class messages_responce
  * @brief Class for handling messages responce from server and printing
  *        it for user.
+ *
+ *        Messages are read one by one from xml::stream_parser. They are
+ *        either kept, or written to the output sink as soon as they are
+ *        read, so printing does not hold them in memory.
  */
-class messages_responce
+class messages_responce : public xml::element_handler
 {
 public:
+    /// @brief Constructor, keeps the read messages.
+    messages_responce();
+
     /**
-     * @brief Generates messages_responce from xml node.
-     * @param s Xml node.
+     * @brief Constructor, prints the read messages and does not keep them.
+     * @param o Output sink, usually io::output_sink.
+     * @param f Output format.
      */
-    void read(xml::node<>* s);
+    messages_responce(std::ostream* o, output_format f);
 
 public:
     /**
-     * @brief Gets the string representation of responce.
-     * @param f Output format.
+     * @brief Reads the message element.
+     * @param s Xml node of message.
      */
-    std::string to_string(output_format f) const;
+    virtual void element(xml::node<>* s);
+
+    /// @brief Flushes the output sink after every part of responce.
+    virtual void flush();
 
 private:
     struct message_item {
@@ -45,7 +59,7 @@ private:
 public:
     typedef std::vector<message_item>::size_type size_type;
 
-    /// @brief Returns the count of messages.
+    /// @brief Returns the count of kept messages.
     size_type size() const
     {
         return m_messages.size();
@@ -61,11 +75,16 @@ public:
     }
 
 private:
-    void write_csv(std::stringstream&) const;
-    void write_table(std::stringstream&) const;
+    void write_csv(const message_item& j);
+    void write_table(const message_item& j);
 
 private:
     std::vector<message_item> m_messages;
+    std::ostream* m_output;
+    output_format m_format;
+    io::csv_ostream m_csv;
+    io::table_printer m_table;
+    bool m_printed;
 };
 
 }
@@ -0,0 +1,154 @@
+#include "mime_form.h"
+#include "exceptions.h"
+#include "rate_limiter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lf {
+
+namespace {
+
+/**
+ * Byte range of file, which is read by curl_mime callbacks. Data is read
+ * by pread straight to the buffer of curl, so it is copied only once.
+ */
+class file_source
+{
+public:
+    file_source(CURL* c, const std::string& file, long long offset, long long size)
+        : m_handle(c)
+        , m_fd(open(file.c_str(), O_RDONLY))
+        , m_offset(offset)
+        , m_size(size)
+        , m_position(0)
+    {
+        if (m_fd < 0) {
+            throw file_error(file, std::strerror(errno));
+        }
+        if (m_size < 0) {
+            struct stat sb;
+            if (fstat(m_fd, &sb) != 0) {
+                std::string e = std::strerror(errno);
+                close(m_fd);
+                throw file_error(file, e);
+            }
+            m_size = std::max(0LL, static_cast<long long>(sb.st_size) - m_offset);
+        }
+#ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(m_fd, m_offset, m_size, POSIX_FADV_SEQUENTIAL);
+#endif
+    }
+
+    ~file_source()
+    {
+        close(m_fd);
+    }
+
+private:
+    file_source(const file_source&);
+    file_source& operator=(const file_source&);
+
+public:
+    long long size() const
+    {
+        return m_size;
+    }
+
+    static size_t read(char* buffer, size_t size, size_t nitems, void* p)
+    {
+        file_source* s = static_cast<file_source*>(p);
+        size_t n = static_cast<size_t>(std::min<long long>(size * nitems,
+                    s->m_size - s->m_position));
+        if (n != 0) {
+            n = rate_limiter::get().acquire(rate_limiter::UPLOAD, s->m_handle, n);
+            if (n == 0) {
+                return CURL_READFUNC_PAUSE;
+            }
+        }
+        size_t done = 0;
+        while (done < n) {
+            ssize_t x = pread(s->m_fd, buffer + done, n - done,
+                    s->m_offset + s->m_position + done);
+            if (x <= 0) {
+                if (x < 0 && errno == EINTR) {
+                    continue;
+                }
+                return CURL_READFUNC_ABORT;
+            }
+            done += x;
+        }
+        s->m_position += done;
+        return done;
+    }
+
+    static int seek(void* p, curl_off_t offset, int origin)
+    {
+        file_source* s = static_cast<file_source*>(p);
+        long long b = origin == SEEK_CUR ? s->m_position
+            : origin == SEEK_END ? s->m_size : 0;
+        if (b + offset < 0 || b + offset > s->m_size) {
+            return CURL_SEEKFUNC_FAIL;
+        }
+        s->m_position = b + offset;
+        return CURL_SEEKFUNC_OK;
+    }
+
+    static void free(void* p)
+    {
+        delete static_cast<file_source*>(p);
+    }
+
+private:
+    CURL* m_handle;
+    int m_fd;
+    long long m_offset;
+    long long m_size;
+    long long m_position;
+};
+
+}
+
+mime_form::mime_form(CURL* c)
+    : m_handle(c)
+    , m_mime(curl_mime_init(c))
+{
+    if (m_mime == 0) {
+        throw curl_error("Failed to initialize CURL");
+    }
+}
+
+mime_form::~mime_form()
+{
+    curl_mime_free(m_mime);
+}
+
+void mime_form::add_field(const std::string& n, const std::string& v)
+{
+    curl_mimepart* p = curl_mime_addpart(m_mime);
+    curl_mime_name(p, n.c_str());
+    curl_mime_data(p, v.data(), v.size());
+}
+
+void mime_form::add_file(const std::string& n, const std::string& file,
+        const std::string& filename, long long offset, long long size)
+{
+    file_source* s = new file_source(m_handle, file, offset, size);
+    curl_mimepart* p = curl_mime_addpart(m_mime);
+    curl_mime_name(p, n.c_str());
+    curl_mime_filename(p, filename.c_str());
+    curl_mime_data_cb(p, s->size(), &file_source::read, &file_source::seek,
+            &file_source::free, s);
+}
+
+void mime_form::post(CURL* c)
+{
+    curl_easy_setopt(c, CURLOPT_MIMEPOST, m_mime);
+}
+
+}
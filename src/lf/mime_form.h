@@ -0,0 +1,63 @@
+#pragma once
+
+#include <curl/curl.h>
+
+#include <string>
+
+namespace lf {
+
+/**
+ * @class mime_form
+ * @brief Multipart form of upload request.
+ *
+ *        Files are not read by curl through stdio, their data is read by
+ *        callback straight to the upload buffer of curl, so the size of
+ *        reads is set by CURLOPT_UPLOAD_BUFFERSIZE. Kernel is advised that
+ *        the files are read sequentially. Reads take their bytes from the
+ *        upload budget of rate_limiter and pause the handle without them.
+ */
+class mime_form
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param c Handle, which will post the form.
+     */
+    mime_form(CURL* c);
+
+    /// @brief Destructor.
+    ~mime_form();
+
+private:
+    mime_form(const mime_form&);
+    mime_form& operator=(const mime_form&);
+
+public:
+    /**
+     * @brief Adds the text field.
+     * @param n Name of field.
+     * @param v Value of field.
+     */
+    void add_field(const std::string& n, const std::string& v);
+
+    /**
+     * @brief Adds the byte range of file.
+     * @param n Name of field.
+     * @param file Path of file.
+     * @param filename Name of file to send to server.
+     * @param offset Offset of the range.
+     * @param size Size of the range, -1 to send the file up to its end.
+     * @throw file_error.
+     */
+    void add_file(const std::string& n, const std::string& file,
+            const std::string& filename, long long offset = 0, long long size = -1);
+
+    /// @brief Sets the form as the body of request of given handle.
+    void post(CURL* c);
+
+private:
+    CURL* m_handle;
+    curl_mime* m_mime;
+};
+
+}
@@ -0,0 +1,164 @@
+#include "rate_limiter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <time.h>
+
+namespace lf {
+
+namespace {
+
+/// Bucket holds the tokens for this time, so the bursts are short.
+double s_burst_time = 0.1;
+
+double s_min_burst = 16 * 1024;
+
+double now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+long long current_rate(const rate_limiter::profile& p)
+{
+    time_t t = time(0);
+    struct tm m;
+    localtime_r(&t, &m);
+    int x = m.tm_hour * 60 + m.tm_min;
+    for (rate_limiter::profile::const_iterator i = p.begin(); i != p.end(); ++i) {
+        bool in = i->m_begin <= i->m_end
+            ? x >= i->m_begin && x < i->m_end
+            : x >= i->m_begin || x < i->m_end;
+        if (in) {
+            return i->m_rate;
+        }
+    }
+    return 0;
+}
+
+void remove(std::deque<CURL*>& q, CURL* c)
+{
+    q.erase(std::remove(q.begin(), q.end(), c), q.end());
+}
+
+}
+
+rate_limiter& rate_limiter::get()
+{
+    static rate_limiter s_instance;
+    return s_instance;
+}
+
+rate_limiter::rate_limiter()
+{
+}
+
+void rate_limiter::set_profile(direction d, const profile& p)
+{
+    base::scoped_lock l(m_mutex);
+    bucket& b = m_buckets[d];
+    b.m_profile = p;
+    b.m_checked = -1;
+}
+
+bool rate_limiter::enabled()
+{
+    base::scoped_lock l(m_mutex);
+    return !m_buckets[UPLOAD].m_profile.empty()
+        || !m_buckets[DOWNLOAD].m_profile.empty();
+}
+
+size_t rate_limiter::acquire(direction d, CURL* c, size_t n)
+{
+    base::scoped_lock l(m_mutex);
+    bucket& b = m_buckets[d];
+    refill(b);
+    if (b.m_rate == 0) {
+        remove(b.m_waiting, c);
+        return n;
+    }
+    bool first = !b.m_waiting.empty() && b.m_waiting.front() == c;
+    if (b.m_tokens > 0 && (b.m_waiting.empty() || first)) {
+        if (first) {
+            b.m_waiting.pop_front();
+        }
+        size_t k = d == UPLOAD
+            ? std::min(n, static_cast<size_t>(capacity(b))) : n;
+        b.m_tokens -= k;
+        return k;
+    }
+    if (std::find(b.m_waiting.begin(), b.m_waiting.end(), c) == b.m_waiting.end()) {
+        b.m_waiting.push_back(c);
+    }
+    return 0;
+}
+
+bool rate_limiter::ready(CURL* c)
+{
+    base::scoped_lock l(m_mutex);
+    for (int d = UPLOAD; d <= DOWNLOAD; ++d) {
+        bucket& b = m_buckets[d];
+        if (std::find(b.m_waiting.begin(), b.m_waiting.end(), c) == b.m_waiting.end()) {
+            continue;
+        }
+        refill(b);
+        if (b.m_rate == 0 || (b.m_waiting.front() == c && b.m_tokens > 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void rate_limiter::forget(CURL* c)
+{
+    base::scoped_lock l(m_mutex);
+    remove(m_buckets[UPLOAD].m_waiting, c);
+    remove(m_buckets[DOWNLOAD].m_waiting, c);
+}
+
+long rate_limiter::delay()
+{
+    base::scoped_lock l(m_mutex);
+    long r = -1;
+    for (int d = UPLOAD; d <= DOWNLOAD; ++d) {
+        bucket& b = m_buckets[d];
+        if (b.m_waiting.empty()) {
+            continue;
+        }
+        refill(b);
+        long x = 0;
+        if (b.m_rate != 0 && b.m_tokens <= 0) {
+            x = static_cast<long>(std::ceil(-b.m_tokens * 1000 / b.m_rate)) + 1;
+        }
+        r = r < 0 ? x : std::min(r, x);
+    }
+    return r;
+}
+
+void rate_limiter::refill(bucket& b)
+{
+    double t = now();
+    if (b.m_checked < 0 || t - b.m_checked >= 1) {
+        b.m_checked = t;
+        long long r = current_rate(b.m_profile);
+        if (r != b.m_rate) {
+            if (b.m_rate == 0) {
+                b.m_tokens = 0;
+            }
+            b.m_rate = r;
+        }
+    }
+    if (b.m_rate != 0) {
+        b.m_tokens = std::min(capacity(b), b.m_tokens + (t - b.m_time) * b.m_rate);
+    }
+    b.m_time = t;
+}
+
+double rate_limiter::capacity(const bucket& b)
+{
+    return std::max(b.m_rate * s_burst_time, s_min_burst);
+}
+
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <base/mutex.h>
+
+#include <curl/curl.h>
+
+#include <deque>
+#include <vector>
+
+namespace lf {
+
+/**
+ * @class rate_limiter
+ * @brief Limits the bandwidth of all the transfers of process.
+ *
+ *        Uploads and downloads take their data from two separate token
+ *        buckets, which are refilled at the rate of current time-of-day
+ *        period. When a bucket is empty, the data callback of transfer
+ *        pauses its handle, and the handle waits in the queue of bucket.
+ *        The queue is served in order, so the transfers share the rate
+ *        fairly, and the running transfers do not overtake the waiting
+ *        ones. The owner of paused handle resumes it when ready returns
+ *        true for it.
+ */
+class rate_limiter
+{
+public:
+    enum direction {
+        UPLOAD,
+        DOWNLOAD
+    };
+
+    /**
+     * @struct period
+     * @brief Rate limit for a period of day.
+     *
+     *        Period, which begins later than it ends, lasts over midnight.
+     *        Rate 0 means unlimited.
+     */
+    struct period
+    {
+        int m_begin;
+        int m_end;
+        long long m_rate;
+
+        period(int b, int e, long long r)
+            : m_begin(b)
+            , m_end(e)
+            , m_rate(r)
+        {
+        }
+    };
+
+    typedef std::vector<period> profile;
+
+public:
+    /// @brief Access to the limiter of process.
+    static rate_limiter& get();
+
+private:
+    rate_limiter();
+    rate_limiter(const rate_limiter&);
+    rate_limiter& operator=(const rate_limiter&);
+
+public:
+    /**
+     * @brief Sets the rate limits of direction.
+     * @param d Direction.
+     * @param p Periods in minutes since midnight, with their rates in bytes
+     *        per second. Time outside of periods is unlimited.
+     */
+    void set_profile(direction d, const profile& p);
+
+    /// @brief Checks whether any direction has rate limits.
+    bool enabled();
+
+    /**
+     * @brief Takes bytes from the bucket of direction.
+     *
+     *        Downloaded data is already received, so it is taken whole
+     *        and the bucket can go in debt. Upload is cut to the size of
+     *        bucket, so uploads do not burst.
+     * @param d Direction.
+     * @param c Handle, which transfers the data.
+     * @param n Count of bytes to transfer.
+     * @return Count of bytes, which can be transferred, 0 if the handle
+     *         should be paused.
+     */
+    size_t acquire(direction d, CURL* c, size_t n);
+
+    /// @brief Checks whether the paused handle can be resumed.
+    bool ready(CURL* c);
+
+    /// @brief Removes the handle from the queues, when its transfer ends.
+    void forget(CURL* c);
+
+    /**
+     * @brief Gets the time, when the first paused handle can be resumed.
+     * @return Milliseconds, -1 if no handle is paused.
+     */
+    long delay();
+
+private:
+    struct bucket
+    {
+        profile m_profile;
+        long long m_rate;
+        double m_tokens;
+        double m_time;
+        double m_checked;
+        std::deque<CURL*> m_waiting;
+
+        bucket()
+            : m_rate(0)
+            , m_tokens(0)
+            , m_time(0)
+            , m_checked(-1)
+        {
+        }
+    };
+
+    void refill(bucket& b);
+    static double capacity(const bucket& b);
+
+private:
+    base::mutex m_mutex;
+    bucket m_buckets[2];
+};
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <curl/curl.h>
+
+#include <string>
+
+namespace lf {
+
+/**
+ * @class responce_buffer
+ * @brief Body of responce, which is received by a handle.
+ *
+ *        Every handle has its own buffer, so handles of several threads
+ *        and transfers do not share the data. When the first data comes,
+ *        the buffer is reserved for the Content-Length of responce, so it
+ *        is not reallocated while it grows. Compressed responces are only
+ *        reserved for their compressed size.
+ */
+class responce_buffer
+{
+public:
+    /// @brief Largest size, which is reserved in advance.
+    static const curl_off_t s_max_reserve = 64 * 1024 * 1024;
+
+public:
+    responce_buffer()
+        : m_handle(0)
+    {
+    }
+
+public:
+    /**
+     * @brief Sets the handle to receive the data of.
+     * @param c Handle, its write callback and data are set to the buffer.
+     */
+    void attach(CURL* c)
+    {
+        m_handle = c;
+        curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, &responce_buffer::write);
+        curl_easy_setopt(c, CURLOPT_WRITEDATA, this);
+    }
+
+    /// @brief Gets the received data.
+    const std::string& data() const
+    {
+        return m_data;
+    }
+
+    /// @brief Forgets the received data, to receive the responce again.
+    void clear()
+    {
+        m_data.clear();
+    }
+
+    /**
+     * @brief Moves the received data to the given string, the buffer is
+     *        left empty.
+     * @param r String, its old content is dropped.
+     */
+    void take(std::string& r)
+    {
+        r.clear();
+        r.swap(m_data);
+    }
+
+private:
+    static size_t write(void* ptr, size_t size, size_t nmemb, responce_buffer* b)
+    {
+        size_t n = size * nmemb;
+        if (b->m_data.empty()) {
+            curl_off_t l = -1;
+            curl_easy_getinfo(b->m_handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &l);
+            curl_off_t m = s_max_reserve;
+            if (l > 0) {
+                b->m_data.reserve(static_cast<size_t>(l < m ? l : m));
+            }
+        }
+        b->m_data.append(static_cast<const char*>(ptr), n);
+        return n;
+    }
+
+private:
+    CURL* m_handle;
+    std::string m_data;
+};
+
+}
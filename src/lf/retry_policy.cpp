@@ -0,0 +1,101 @@
+#include "retry_policy.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <time.h>
+#include <unistd.h>
+
+namespace lf {
+
+namespace {
+
+/// Backoff of the first retry, it is doubled for every next one.
+long s_base_backoff = 500;
+
+long s_max_backoff = 30 * 1000;
+
+}
+
+const unsigned retry_policy::s_attempts;
+
+retry_policy& retry_policy::get()
+{
+    static retry_policy s_instance;
+    return s_instance;
+}
+
+retry_policy::retry_policy()
+    : m_seed(static_cast<unsigned>(time(0)) ^ static_cast<unsigned>(getpid()))
+{
+}
+
+bool retry_policy::transient(CURLcode r, long status)
+{
+    switch (r) {
+    case CURLE_OK:
+    case CURLE_HTTP_RETURNED_ERROR:
+        return status == 429 || status == 502 || status == 503 || status == 504;
+    case CURLE_COULDNT_RESOLVE_PROXY:
+    case CURLE_COULDNT_RESOLVE_HOST:
+    case CURLE_COULDNT_CONNECT:
+    case CURLE_PARTIAL_FILE:
+    case CURLE_OPERATION_TIMEDOUT:
+    case CURLE_SSL_CONNECT_ERROR:
+    case CURLE_GOT_NOTHING:
+    case CURLE_SEND_ERROR:
+    case CURLE_RECV_ERROR:
+    case CURLE_HTTP2:
+    case CURLE_HTTP2_STREAM:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool retry_policy::unsent(CURLcode r)
+{
+    return r == CURLE_COULDNT_RESOLVE_PROXY || r == CURLE_COULDNT_RESOLVE_HOST
+        || r == CURLE_COULDNT_CONNECT || r == CURLE_SSL_CONNECT_ERROR;
+}
+
+bool retry_policy::replay(CURL* c, CURLcode r, unsigned attempt, bool replayable)
+{
+    long status = 0;
+    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &status);
+    if (attempt >= s_attempts || !transient(r, status)) {
+        return false;
+    }
+    if (replayable || unsent(r)) {
+        return true;
+    }
+    char* m = 0;
+    curl_easy_getinfo(c, CURLINFO_EFFECTIVE_METHOD, &m);
+    return m != 0 && (std::strcmp(m, "GET") == 0 || std::strcmp(m, "HEAD") == 0
+            || std::strcmp(m, "DELETE") == 0);
+}
+
+long retry_policy::backoff(unsigned attempt, curl_off_t retry_after)
+{
+    long d = s_base_backoff << std::min(attempt - 1, 16u);
+    d = std::min(d, s_max_backoff);
+    base::scoped_lock l(m_mutex);
+    // Half of the time is random, so the waits of clients are spread.
+    d = d / 2 + rand_r(&m_seed) % (d / 2 + 1);
+    if (retry_after > 0) {
+        d = std::max(d, static_cast<long>(
+                    std::min<curl_off_t>(retry_after * 1000, s_max_backoff)));
+    }
+    ++m_statistics.m_retries;
+    m_statistics.m_backoff += d;
+    return d;
+}
+
+retry_policy::statistics retry_policy::get_statistics()
+{
+    base::scoped_lock l(m_mutex);
+    return m_statistics;
+}
+
+}
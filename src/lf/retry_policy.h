@@ -0,0 +1,95 @@
+#pragma once
+
+#include <base/mutex.h>
+
+#include <curl/curl.h>
+
+namespace lf {
+
+/**
+ * @class retry_policy
+ * @brief Decides, which failed requests are repeated, and when.
+ *
+ *        Failures of connection, TLS handshake, timeouts and the responces
+ *        429, 502, 503 and 504 are transient, other failures are final.
+ *        Request, which failed before it was sent, can always be repeated,
+ *        otherwise only GET, HEAD and DELETE requests, and the requests
+ *        marked by caller, like chunk uploads, are repeated.
+ *        Repeated requests wait for exponentially growing time with random
+ *        jitter, so the clients of overloaded server do not retry at once,
+ *        or for the time asked by Retry-After header.
+ */
+class retry_policy
+{
+public:
+    /// @brief Maximal count of attempts of one request.
+    static const unsigned s_attempts = 5;
+
+    /**
+     * @struct statistics
+     * @brief Counters of repeated requests.
+     */
+    struct statistics
+    {
+        statistics()
+            : m_retries(0)
+            , m_backoff(0)
+        {
+        }
+
+        /// @brief Count of repeated requests.
+        unsigned long m_retries;
+
+        /// @brief Time waited before the repeated requests in milliseconds.
+        unsigned long long m_backoff;
+    };
+
+public:
+    /// @brief Access to the policy of process.
+    static retry_policy& get();
+
+private:
+    retry_policy();
+    retry_policy(const retry_policy&);
+    retry_policy& operator=(const retry_policy&);
+
+public:
+    /**
+     * @brief Checks whether the failure can pass, if request is repeated.
+     * @param r Result of request.
+     * @param status HTTP status of responce, 0 if there is none.
+     */
+    static bool transient(CURLcode r, long status);
+
+    /// @brief Checks whether the request failed before it was sent.
+    static bool unsent(CURLcode r);
+
+    /**
+     * @brief Checks whether the finished request of handle is repeated.
+     * @param c Handle.
+     * @param r Result of request.
+     * @param attempt Count of attempts done.
+     * @param replayable Request can be repeated, even if it was sent and
+     *        its method is not idempotent.
+     */
+    bool replay(CURL* c, CURLcode r, unsigned attempt, bool replayable = false);
+
+    /**
+     * @brief Gets the time to wait before the next attempt, and counts the
+     *        attempt in statistics.
+     * @param attempt Count of attempts done.
+     * @param retry_after Seconds asked by Retry-After header, 0 if none.
+     * @return Milliseconds.
+     */
+    long backoff(unsigned attempt, curl_off_t retry_after);
+
+    /// @brief Gets the counters.
+    statistics get_statistics();
+
+private:
+    base::mutex m_mutex;
+    unsigned m_seed;
+    statistics m_statistics;
+};
+
+}
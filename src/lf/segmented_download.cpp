@@ -0,0 +1,367 @@
+#include "segmented_download.h"
+#include "crc32.h"
+#include "exceptions.h"
+#include "rate_limiter.h"
+#include "retry_policy.h"
+#include "transfer_queue.h"
+
+#include <base/string.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace lf {
+
+namespace {
+
+long long s_min_segment_size = 1024 * 1024;
+
+long s_receive_buffer_size = 256 * 1024;
+
+/// Appends the text to file, false if it is not written whole.
+bool append(int fd, const std::string& t)
+{
+    return write(fd, t.data(), t.size()) == static_cast<ssize_t>(t.size());
+}
+
+}
+
+const unsigned segmented_download::s_max_host_connections;
+
+/**
+ * Fetches the byte range of file and writes it to the file at its offset.
+ * End of range can be moved back while the segment runs, then the data
+ * after the new end is dropped and the transfer is aborted.
+ */
+class segmented_download::segment : public transfer
+{
+public:
+    segment(segmented_download& d, long long b, long long e)
+        : m_download(d)
+        , m_handle(0)
+        , m_begin(b)
+        , m_position(b)
+        , m_end(e)
+        , m_attempts(0)
+        , m_checked(false)
+        , m_crc32(0)
+    {
+    }
+
+    ~segment()
+    {
+        m_download.remove(this);
+    }
+
+public:
+    virtual void prepare(CURL* c)
+    {
+        m_handle = c;
+        m_checked = false;
+        std::string r = base::to_string(m_position) + "-"
+            + base::to_string(m_end - 1);
+        curl_easy_setopt(c, CURLOPT_URL, m_download.m_url.c_str());
+        curl_easy_setopt(c, CURLOPT_RANGE, r.c_str());
+        curl_easy_setopt(c, CURLOPT_FAILONERROR, 1L);
+        curl_easy_setopt(c, CURLOPT_BUFFERSIZE, s_receive_buffer_size);
+        curl_easy_setopt(c, CURLOPT_ACCEPT_ENCODING, static_cast<char*>(0));
+        curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, &segment::write);
+        curl_easy_setopt(c, CURLOPT_WRITEDATA, this);
+    }
+
+    virtual void finish(const std::string&)
+    {
+        if (m_position != m_end) {
+            throw curl_error("Server closed the segment of file before its end.");
+        }
+        m_download.segment_done(m_begin, m_end, m_crc32);
+    }
+
+    virtual void fail(CURLcode r)
+    {
+        if (r == CURLE_WRITE_ERROR && m_position == m_end) {
+            // Segment was shortened by split.
+            m_download.segment_done(m_begin, m_end, m_crc32);
+            return;
+        }
+        transfer::fail(r);
+    }
+
+    virtual bool retry()
+    {
+        return m_download.m_ranges && ++m_attempts < retry_policy::s_attempts;
+    }
+
+public:
+    long long remaining() const
+    {
+        return m_end - m_position;
+    }
+
+    /**
+     * Moves the end of segment to the middle of its remaining range.
+     * Returns the previous end.
+     */
+    long long split()
+    {
+        long long e = m_end;
+        m_end = m_position + remaining() / 2;
+        return e;
+    }
+
+    long long end() const
+    {
+        return m_end;
+    }
+
+private:
+    static size_t write(char* ptr, size_t size, size_t nmemb, segment* s)
+    {
+        if (rate_limiter::get().acquire(rate_limiter::DOWNLOAD,
+                    s->m_handle, size * nmemb) == 0) {
+            return CURL_WRITEFUNC_PAUSE;
+        }
+        if (!s->m_checked) {
+            s->m_checked = true;
+            long c = 0;
+            curl_easy_getinfo(s->m_handle, CURLINFO_RESPONSE_CODE, &c);
+            if (c != 206) {
+                s->m_download.m_ranges = false;
+                return 0;
+            }
+        }
+        size_t n = static_cast<size_t>(std::min<long long>(size * nmemb,
+                    s->remaining()));
+        size_t done = 0;
+        while (done < n) {
+            ssize_t x = pwrite(s->m_download.m_fd, ptr + done, n - done,
+                    s->m_position + done);
+            if (x < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            done += x;
+        }
+        if (s->m_download.m_crc) {
+            s->m_crc32 = crc32_update(s->m_crc32, ptr, done);
+        }
+        s->m_position += done;
+        return done;
+    }
+
+private:
+    segmented_download& m_download;
+    CURL* m_handle;
+    long long m_begin;
+    long long m_position;
+    long long m_end;
+    unsigned m_attempts;
+    bool m_checked;
+    uint32_t m_crc32;
+};
+
+segmented_download::segmented_download(connection_pool& p,
+        CURL* c,
+        const std::string& url,
+        const std::string& file,
+        long long size,
+        unsigned n,
+        bool crc)
+    : m_pool(p)
+    , m_prototype(c)
+    , m_url(url)
+    , m_file(file)
+    , m_fd(-1)
+    , m_record(-1)
+    , m_size(size)
+    , m_count(std::max(1u, std::min(n, s_max_host_connections)))
+    , m_crc(crc)
+    , m_ranges(true)
+    , m_queue(0)
+{
+    bool resume = load();
+    std::string r = record(m_file);
+    m_record = open(r.c_str(), O_WRONLY | O_CREAT | O_APPEND
+            | (resume ? 0 : O_TRUNC), 0666);
+    if (m_record < 0) {
+        throw file_error(r, strerror(errno));
+    }
+    // Record is written before any data, so the file is never taken for
+    // a contiguous one.
+    if (!resume && !append(m_record, "size " + base::to_string(m_size)
+                + " crc " + base::to_string(m_crc ? 1 : 0) + "\n")) {
+        close(m_record);
+        throw file_error(r, strerror(errno));
+    }
+    m_fd = open(m_file.c_str(), O_WRONLY | O_CREAT | (resume ? 0 : O_TRUNC), 0666);
+    if (m_fd < 0) {
+        close(m_record);
+        throw file_error(m_file, strerror(errno));
+    }
+}
+
+segmented_download::~segmented_download()
+{
+    close(m_fd);
+    close(m_record);
+}
+
+std::string segmented_download::record(const std::string& file)
+{
+    return file + ".segments";
+}
+
+bool segmented_download::resumable(const std::string& file)
+{
+    return access(record(file).c_str(), F_OK) == 0;
+}
+
+void segmented_download::discard(const std::string& file)
+{
+    unlink(file.c_str());
+    unlink(record(file).c_str());
+}
+
+/**
+ * Reads the finished segments of the previous download, if it was of the
+ * same size and computed the same checksums, and its file is still there.
+ * Line, which was not written whole, is dropped.
+ */
+bool segmented_download::load()
+{
+    if (access(m_file.c_str(), F_OK) != 0) {
+        return false;
+    }
+    std::ifstream f(record(m_file).c_str());
+    std::string line;
+    long long size = -1;
+    int crc = -1;
+    if (!std::getline(f, line)
+            || std::sscanf(line.c_str(), "size %lld crc %d", &size, &crc) != 2
+            || size != m_size || crc != (m_crc ? 1 : 0)) {
+        return false;
+    }
+    while (std::getline(f, line) && !f.eof()) {
+        part p;
+        unsigned long c = 0;
+        if (std::sscanf(line.c_str(), "%lld %lld %lx", &p.m_begin, &p.m_size, &c) != 3
+                || p.m_begin < 0 || p.m_size <= 0 || p.m_begin + p.m_size > m_size) {
+            break;
+        }
+        p.m_crc32 = static_cast<uint32_t>(c);
+        m_parts.push_back(p);
+    }
+    return true;
+}
+
+bool segmented_download::run()
+{
+    transfer_queue q(m_pool, m_prototype, m_count, false);
+    m_queue = &q;
+    // Missing ranges are split evenly between the connections.
+    std::sort(m_parts.begin(), m_parts.end());
+    std::vector<std::pair<long long, long long> > gaps;
+    long long b = 0;
+    std::vector<part>::const_iterator i = m_parts.begin();
+    for (; i != m_parts.end(); ++i) {
+        if (i->m_begin > b) {
+            gaps.push_back(std::make_pair(b, i->m_begin));
+        }
+        b = std::max(b, i->m_begin + i->m_size);
+    }
+    if (b < m_size) {
+        gaps.push_back(std::make_pair(b, m_size));
+    }
+    long long missing = m_size - resumed();
+    long long s = std::max(1LL, (missing + m_count - 1) / m_count);
+    std::vector<std::pair<long long, long long> >::const_iterator g = gaps.begin();
+    for (; g != gaps.end(); ++g) {
+        for (long long x = g->first; x < g->second; x += s) {
+            add(x, std::min(x + s, g->second));
+        }
+    }
+    try {
+        q.run();
+    } catch (curl_error&) {
+        m_queue = 0;
+        if (!m_ranges) {
+            return false;
+        }
+        throw;
+    }
+    m_queue = 0;
+    return true;
+}
+
+void segmented_download::add(long long b, long long e)
+{
+    segment* s = new segment(*this, b, e);
+    m_segments.push_back(s);
+    m_queue->push(s);
+}
+
+long long segmented_download::resumed() const
+{
+    long long n = 0;
+    std::vector<part>::const_iterator i = m_parts.begin();
+    for (; i != m_parts.end(); ++i) {
+        n += i->m_size;
+    }
+    return n;
+}
+
+uint32_t segmented_download::crc32() const
+{
+    std::vector<part> p(m_parts);
+    std::sort(p.begin(), p.end());
+    uint32_t c = 0;
+    std::vector<part>::const_iterator i = p.begin();
+    for (; i != p.end(); ++i) {
+        c = crc32_combine(c, i->m_crc32, i->m_size);
+    }
+    return c;
+}
+
+void segmented_download::segment_done(long long b, long long e, uint32_t c)
+{
+    part p;
+    p.m_begin = b;
+    p.m_size = e - b;
+    p.m_crc32 = c;
+    m_parts.push_back(p);
+    char line[64];
+    std::snprintf(line, sizeof(line), "%lld %lld %lx\n", b, e - b,
+            static_cast<unsigned long>(c));
+    append(m_record, line);
+    segment* l = 0;
+    std::vector<segment*>::iterator i = m_segments.begin();
+    for (; i != m_segments.end(); ++i) {
+        if (l == 0 || (*i)->remaining() > l->remaining()) {
+            l = *i;
+        }
+    }
+    if (l == 0 || l->remaining() < 2 * s_min_segment_size) {
+        return;
+    }
+    long long n = l->split();
+    add(l->end(), n);
+}
+
+void segmented_download::remove(segment* s)
+{
+    std::vector<segment*>::iterator i =
+        std::find(m_segments.begin(), m_segments.end(), s);
+    if (i != m_segments.end()) {
+        m_segments.erase(i);
+    }
+}
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <curl/curl.h>
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace lf {
+
+class connection_pool;
+class transfer_queue;
+
+/**
+ * @class segmented_download
+ * @brief Downloads the file by several byte ranges simultaneously.
+ *
+ *        File is split to segments, each of which is fetched on its own
+ *        connection, also over HTTP/2, and written in place. When a segment
+ *        is finished, the segment with the most remaining data is split in
+ *        two, so the faster connections take over the work of lagging ones.
+ *        CRC-32 of every segment is computed as its data arrives, and they
+ *        are combined to CRC-32 of the whole file.
+ *
+ *        Finished segments are appended to the record file next to the
+ *        file, so an interrupted download fetches only the missing ranges
+ *        when it is started again. File, which has the record, has holes
+ *        and must not be resumed from its end.
+ */
+class segmented_download
+{
+public:
+    /// @brief Maximal count of connections opened to one host.
+    static const unsigned s_max_host_connections = 8;
+
+public:
+    /**
+     * @brief Constructor.
+     * @param p Connection pool.
+     * @param c Prototype handle for segment requests.
+     * @param url URL of the file.
+     * @param file Path of the file to write to.
+     * @param size Size of the file.
+     * @param n Count of connections, at most s_max_host_connections.
+     * @param crc Compute CRC-32 of file.
+     * @throw file_error.
+     */
+    segmented_download(connection_pool& p,
+            CURL* c,
+            const std::string& url,
+            const std::string& file,
+            long long size,
+            unsigned n,
+            bool crc);
+
+    /// @brief Destructor.
+    ~segmented_download();
+
+    /// @brief Checks whether the file is left by an interrupted download.
+    static bool resumable(const std::string& file);
+
+    /// @brief Removes the file and its record.
+    static void discard(const std::string& file);
+
+private:
+    segmented_download(const segmented_download&);
+    segmented_download& operator=(const segmented_download&);
+
+public:
+    /**
+     * @brief Downloads all the segments and waits for them.
+     * @return False if server does not support byte ranges.
+     * @throw curl_error, file_error.
+     */
+    bool run();
+
+    /// @brief Gets CRC-32 of downloaded file.
+    uint32_t crc32() const;
+
+    /// @brief Gets the size of segments, which were finished before.
+    long long resumed() const;
+
+private:
+    class segment;
+
+    struct part
+    {
+        long long m_begin;
+        long long m_size;
+        uint32_t m_crc32;
+
+        bool operator<(const part& p) const
+        {
+            return m_begin < p.m_begin;
+        }
+    };
+
+    static std::string record(const std::string& file);
+    bool load();
+    void add(long long b, long long e);
+    void segment_done(long long b, long long e, uint32_t c);
+    void remove(segment* s);
+
+private:
+    connection_pool& m_pool;
+    CURL* m_prototype;
+    std::string m_url;
+    std::string m_file;
+    int m_fd;
+    int m_record;
+    long long m_size;
+    unsigned m_count;
+    bool m_crc;
+    bool m_ranges;
+    transfer_queue* m_queue;
+    std::vector<segment*> m_segments;
+    std::vector<part> m_parts;
+};
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <stdint.h>
+
+namespace lf {
+
+/**
+ * @class sha256
+ * @brief Incremental SHA-256 digest.
+ */
+class sha256
+{
+public:
+    /// @brief Constructor.
+    sha256();
+
+public:
+    /// @brief Starts the new digest.
+    void reset();
+
+    /**
+     * @brief Adds the next bytes of data to digest.
+     * @param d Data.
+     * @param n Size of data.
+     */
+    void update(const char* d, size_t n);
+
+    /// @brief Gets the digest of added data as lowercase hex string.
+    std::string hex_digest() const;
+
+private:
+    void transform(const unsigned char* b);
+
+private:
+    uint32_t m_state[8];
+    unsigned char m_block[64];
+    size_t m_block_size;
+    uint64_t m_size;
+};
+
+}
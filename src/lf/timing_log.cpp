@@ -0,0 +1,189 @@
+#include "timing_log.h"
+#include "exceptions.h"
+
+#include <base/string.h>
+#include <base/thread.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace lf {
+
+namespace {
+
+base::thread_specific<timing_log*> s_current;
+
+timing_log* s_default = 0;
+
+const char* s_csv_header = "time,method,url,status,result,reused,"
+    "dns_us,connect_us,tls_us,pretransfer_us,ttfb_us,total_us,"
+    "bytes_up,bytes_down,bytes_decoded\n";
+
+bool ends_with(const std::string& s, const std::string& e)
+{
+    return s.size() >= e.size() && s.compare(s.size() - e.size(), e.size(), e) == 0;
+}
+
+std::string current_time()
+{
+    struct timeval t;
+    gettimeofday(&t, 0);
+    struct tm m;
+    gmtime_r(&t.tv_sec, &m);
+    char b[64];
+    std::sprintf(b, "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", m.tm_year + 1900,
+            m.tm_mon + 1, m.tm_mday, m.tm_hour, m.tm_min, m.tm_sec,
+            static_cast<int>(t.tv_usec / 1000));
+    return b;
+}
+
+std::string csv_quote(const std::string& s)
+{
+    if (s.find_first_of(",\"\n") == std::string::npos) {
+        return s;
+    }
+    std::string r = "\"";
+    for (std::string::size_type i = 0; i < s.size(); ++i) {
+        if (s[i] == '"') {
+            r += '"';
+        }
+        r += s[i];
+    }
+    return r + "\"";
+}
+
+std::string json_quote(const std::string& s)
+{
+    std::string r = "\"";
+    for (std::string::size_type i = 0; i < s.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c == '"' || c == '\\') {
+            r += '\\';
+            r += s[i];
+        } else if (c < 0x20) {
+            char b[8];
+            std::sprintf(b, "\\u%04x", c);
+            r += b;
+        } else {
+            r += s[i];
+        }
+    }
+    return r + "\"";
+}
+
+curl_off_t get_off(CURL* c, CURLINFO i)
+{
+    curl_off_t v = 0;
+    curl_easy_getinfo(c, i, &v);
+    return v;
+}
+
+std::string get_string(CURL* c, CURLINFO i)
+{
+    char* v = 0;
+    curl_easy_getinfo(c, i, &v);
+    return v == 0 ? std::string() : std::string(v);
+}
+
+}
+
+timing_log::timing_log(const std::string& f)
+    : m_fd(open(f.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0666))
+    , m_json(ends_with(f, ".json") || ends_with(f, ".jsonl"))
+{
+    if (m_fd < 0) {
+        throw file_error(f, std::strerror(errno));
+    }
+    struct stat sb;
+    if (!m_json && fstat(m_fd, &sb) == 0 && sb.st_size == 0) {
+        ssize_t x = write(m_fd, s_csv_header, std::strlen(s_csv_header));
+        (void)x;
+    }
+}
+
+timing_log::~timing_log()
+{
+    close(m_fd);
+}
+
+void timing_log::record(CURL* c, CURLcode r, curl_off_t n)
+{
+    long status = 0;
+    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &status);
+    long connects = 0;
+    curl_easy_getinfo(c, CURLINFO_NUM_CONNECTS, &connects);
+    static const char* names[] = { "dns_us", "connect_us", "tls_us",
+        "pretransfer_us", "ttfb_us", "total_us", "bytes_up", "bytes_down",
+        "bytes_decoded" };
+    curl_off_t values[] = {
+        get_off(c, CURLINFO_NAMELOOKUP_TIME_T),
+        get_off(c, CURLINFO_CONNECT_TIME_T),
+        get_off(c, CURLINFO_APPCONNECT_TIME_T),
+        get_off(c, CURLINFO_PRETRANSFER_TIME_T),
+        get_off(c, CURLINFO_STARTTRANSFER_TIME_T),
+        get_off(c, CURLINFO_TOTAL_TIME_T),
+        get_off(c, CURLINFO_SIZE_UPLOAD_T),
+        get_off(c, CURLINFO_SIZE_DOWNLOAD_T),
+        n
+    };
+    if (n < 0) {
+        values[8] = values[7];
+    }
+    const int k = sizeof(values) / sizeof(values[0]);
+    std::string method = get_string(c, CURLINFO_EFFECTIVE_METHOD);
+    std::string url = get_string(c, CURLINFO_EFFECTIVE_URL);
+    std::string l;
+    if (m_json) {
+        l = "{\"time\":\"" + current_time() + "\",\"method\":" + json_quote(method)
+            + ",\"url\":" + json_quote(url)
+            + ",\"status\":" + base::to_string(status)
+            + ",\"result\":" + base::to_string(static_cast<int>(r))
+            + ",\"reused\":" + (connects == 0 ? "true" : "false");
+        for (int i = 0; i < k; ++i) {
+            l += std::string(",\"") + names[i] + "\":"
+                + base::to_string(static_cast<long long>(values[i]));
+        }
+        l += "}\n";
+    } else {
+        l = current_time() + "," + csv_quote(method) + "," + csv_quote(url)
+            + "," + base::to_string(status)
+            + "," + base::to_string(static_cast<int>(r))
+            + "," + (connects == 0 ? "1" : "0");
+        for (int i = 0; i < k; ++i) {
+            l += "," + base::to_string(static_cast<long long>(values[i]));
+        }
+        l += "\n";
+    }
+    ssize_t x = write(m_fd, l.data(), l.size());
+    (void)x;
+}
+
+timing_log::scope::scope(timing_log* l)
+    : m_previous(s_current.get())
+{
+    s_current.get() = l;
+}
+
+timing_log::scope::~scope()
+{
+    s_current.get() = m_previous;
+}
+
+void timing_log::set_default(timing_log* l)
+{
+    s_default = l;
+}
+
+timing_log* timing_log::current()
+{
+    timing_log* l = s_current.get();
+    return l != 0 ? l : s_default;
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <curl/curl.h>
+
+#include <string>
+
+namespace lf {
+
+/**
+ * @class timing_log
+ * @brief Writes the timings of finished requests to file.
+ *
+ *        Every request is written as one line with the time of its phases
+ *        in microseconds, bytes sent and received, HTTP status and whether
+ *        the connection was reused. Received bytes are counted as they came
+ *        by wire and after decoding of compressed response. Lines are in
+ *        JSON when the file name ends with ".json" or ".jsonl", otherwise in
+ *        CSV with a header.
+ *        Lines are appended to the file by single writes, so several
+ *        logs, also of several processes, can write to the same file.
+ *
+ *        Requests are written to the log of calling thread, which is set
+ *        by scope, or to the default log of process.
+ */
+class timing_log
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param f Path of file.
+     * @throw file_error.
+     */
+    timing_log(const std::string& f);
+
+    /// @brief Destructor.
+    ~timing_log();
+
+private:
+    timing_log(const timing_log&);
+    timing_log& operator=(const timing_log&);
+
+public:
+    /**
+     * @brief Writes the line of finished request.
+     * @param c Handle of request.
+     * @param r Result of request.
+     * @param n Size of decoded response body, -1 if it is the same as the
+     *        size received.
+     */
+    void record(CURL* c, CURLcode r, curl_off_t n);
+
+public:
+    /**
+     * @class scope
+     * @brief Sets the log of calling thread for the lifetime of object.
+     */
+    class scope
+    {
+    public:
+        scope(timing_log* l);
+        ~scope();
+
+    private:
+        scope(const scope&);
+        scope& operator=(const scope&);
+
+    private:
+        timing_log* m_previous;
+    };
+
+    /// @brief Sets the log of threads, which have no log of their own.
+    static void set_default(timing_log* l);
+
+    /// @brief Gets the log of calling thread, 0 if there is none.
+    static timing_log* current();
+
+private:
+    int m_fd;
+    bool m_json;
+};
+
+}
@@ -0,0 +1,312 @@
+#include "transfer_queue.h"
+#include "connection_pool.h"
+#include "exceptions.h"
+#include "rate_limiter.h"
+#include "retry_policy.h"
+
+#include <algorithm>
+
+#include <time.h>
+
+namespace lf {
+
+namespace {
+
+/// Period to ask the source for transfers, while the queue waits for it.
+long s_source_delay = 10;
+
+/// Waits for the sockets, but not beyond the time of paused handles.
+long wait_timeout()
+{
+    long d = rate_limiter::get().delay();
+    return d < 0 ? 1000 : std::min(1000L, std::max(1L, d));
+}
+
+double now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+void resume(CURL* c)
+{
+    if (rate_limiter::get().ready(c)) {
+        curl_easy_pause(c, CURLPAUSE_CONT);
+    }
+}
+
+}
+
+void transfer::fail(CURLcode r)
+{
+    throw curl_error(std::string(curl_easy_strerror(r)));
+}
+
+const long transfer_queue::s_max_host_connections;
+
+transfer_queue::transfer_queue(connection_pool& p, CURL* c, unsigned n,
+        bool multiplex)
+    : m_pool(p)
+    , m_prototype(c)
+    , m_multi(0)
+    , m_limit(n == 0 ? 1 : n)
+    , m_connected(!multiplex)
+    , m_source(0)
+{
+    m_multi = curl_multi_init();
+    if (m_multi == 0) {
+        throw curl_error("Failed to initialize CURL");
+    }
+    curl_multi_setopt(m_multi, CURLMOPT_PIPELINING,
+            multiplex ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+    curl_multi_setopt(m_multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+            s_max_host_connections);
+}
+
+transfer_queue::~transfer_queue()
+{
+    while (!m_active.empty()) {
+        slot* s = m_active.back();
+        m_active.pop_back();
+        transfer* t = s->m_transfer;
+        release(s);
+        delete t;
+    }
+    while (!m_pending.empty()) {
+        delete m_pending.front();
+        m_pending.pop_front();
+    }
+    std::multimap<double, transfer*>::iterator i = m_delayed.begin();
+    for (; i != m_delayed.end(); ++i) {
+        delete i->second;
+    }
+    curl_multi_cleanup(m_multi);
+}
+
+void transfer_queue::push(transfer* t)
+{
+    m_pending.push_back(t);
+}
+
+void transfer_queue::push_front(transfer* t)
+{
+    m_pending.push_front(t);
+}
+
+void transfer_queue::set_source(transfer_source* s)
+{
+    m_source = s;
+}
+
+void transfer_queue::run()
+{
+    int running = 0;
+    while (!m_pending.empty() || !m_active.empty() || !m_delayed.empty()
+            || m_source != 0) {
+        schedule();
+        if (m_source != 0 && m_pending.empty() && !m_source->feed(*this)) {
+            m_source = 0;
+        }
+        // Until the first transfer is connected, it is not known whether
+        // the others can be multiplexed over its connection. CURLOPT_PIPEWAIT
+        // is not used for it, as connections are shared with the queues of
+        // other threads, and the multi handle is not woken up by them.
+        unsigned l = m_connected ? m_limit : 1;
+        while (m_active.size() < l && !m_pending.empty()) {
+            transfer* t = m_pending.front();
+            m_pending.pop_front();
+            start(t);
+        }
+        CURLMcode mc = curl_multi_perform(m_multi, &running);
+        if (mc != CURLM_OK) {
+            throw curl_error(curl_multi_strerror(mc));
+        }
+        CURLMsg* m = 0;
+        int left = 0;
+        while ((m = curl_multi_info_read(m_multi, &left)) != 0) {
+            if (m->msg == CURLMSG_DONE) {
+                done(m->easy_handle, m->data.result);
+            }
+        }
+        for (std::vector<slot*>::size_type i = 0; i < m_active.size(); ++i) {
+            resume(m_active[i]->m_handle);
+            if (!m_connected) {
+                curl_off_t t = 0;
+                curl_easy_getinfo(m_active[i]->m_handle, CURLINFO_PRETRANSFER_TIME_T, &t);
+                m_connected = t > 0;
+            }
+        }
+        long d = delay();
+        if (running != 0) {
+            long w = wait_timeout();
+            curl_multi_wait(m_multi, 0, 0, d < 0 ? w : std::min(w, std::max(d, 1L)), 0);
+        } else if (m_active.empty() && m_pending.empty() && d > 0) {
+            struct timespec t;
+            t.tv_sec = d / 1000;
+            t.tv_nsec = d % 1000 * 1000000;
+            nanosleep(&t, 0);
+        }
+    }
+}
+
+CURLcode transfer_queue::perform(CURL* c)
+{
+    if (!rate_limiter::get().enabled()) {
+        return curl_easy_perform(c);
+    }
+    CURLM* m = curl_multi_init();
+    if (m == 0) {
+        return CURLE_OUT_OF_MEMORY;
+    }
+    curl_multi_add_handle(m, c);
+    CURLcode r = CURLE_OK;
+    int running = 1;
+    while (running != 0) {
+        CURLMcode mc = curl_multi_perform(m, &running);
+        if (mc != CURLM_OK) {
+            r = CURLE_RECV_ERROR;
+            break;
+        }
+        resume(c);
+        if (running != 0) {
+            curl_multi_wait(m, 0, 0, wait_timeout(), 0);
+        }
+    }
+    CURLMsg* x = 0;
+    int left = 0;
+    while ((x = curl_multi_info_read(m, &left)) != 0) {
+        if (x->msg == CURLMSG_DONE) {
+            r = x->data.result;
+        }
+    }
+    rate_limiter::get().forget(c);
+    curl_multi_remove_handle(m, c);
+    curl_multi_cleanup(m);
+    return r;
+}
+
+void transfer_queue::start(transfer* t)
+{
+    CURL* c = 0;
+    try {
+        c = m_pool.duplicate(m_prototype);
+    } catch (...) {
+        delete t;
+        throw;
+    }
+    slot* s = new slot;
+    s->m_handle = c;
+    s->m_transfer = t;
+    m_active.push_back(s);
+    s->m_responce.attach(c);
+    curl_easy_setopt(c, CURLOPT_PRIVATE, s);
+    try {
+        t->prepare(c);
+    } catch (base::exception& e) {
+        m_active.pop_back();
+        release(s);
+        bool handled = t->give_up(e);
+        delete t;
+        if (!handled) {
+            throw;
+        }
+        return;
+    } catch (...) {
+        m_active.pop_back();
+        release(s);
+        delete t;
+        throw;
+    }
+    curl_multi_add_handle(m_multi, c);
+}
+
+void transfer_queue::done(CURL* c, CURLcode r)
+{
+    m_connected = true;
+    slot* s = 0;
+    curl_easy_getinfo(c, CURLINFO_PRIVATE, &s);
+    m_active.erase(std::find(m_active.begin(), m_active.end(), s));
+    // Empty data means that the transfer wrote the body itself.
+    m_pool.account(c, r, s->m_responce.data().empty() ? -1
+            : static_cast<curl_off_t>(s->m_responce.data().size()));
+    long status = 0;
+    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &status);
+    curl_off_t retry_after = 0;
+    curl_easy_getinfo(c, CURLINFO_RETRY_AFTER, &retry_after);
+    // Errors of finish are checked by transfer itself.
+    bool transient = retry_policy::transient(r, status)
+        || (r == CURLE_OK && status < 400);
+    transfer* t = s->m_transfer;
+    std::string data;
+    s->m_responce.take(data);
+    // Handle is released after the transfer has read its status.
+    try {
+        if (r != CURLE_OK) {
+            t->fail(r);
+        } else {
+            t->finish(data);
+        }
+    } catch (base::exception& e) {
+        release(s);
+        unsigned& a = m_failures[t];
+        ++a;
+        if ((transient && t->retry())
+                || (retry_policy::unsent(r) && a < retry_policy::s_attempts)) {
+            postpone(t, retry_after);
+            return;
+        }
+        m_failures.erase(t);
+        bool handled = t->give_up(e);
+        delete t;
+        if (!handled) {
+            throw;
+        }
+        return;
+    } catch (...) {
+        release(s);
+        m_failures.erase(t);
+        delete t;
+        throw;
+    }
+    release(s);
+    m_failures.erase(t);
+    delete t;
+}
+
+void transfer_queue::postpone(transfer* t, curl_off_t retry_after)
+{
+    long d = retry_policy::get().backoff(m_failures[t], retry_after);
+    m_delayed.insert(std::make_pair(now() + d / 1000.0, t));
+}
+
+void transfer_queue::schedule()
+{
+    double n = now();
+    while (!m_delayed.empty() && m_delayed.begin()->first <= n) {
+        m_pending.push_back(m_delayed.begin()->second);
+        m_delayed.erase(m_delayed.begin());
+    }
+}
+
+long transfer_queue::delay() const
+{
+    long d = -1;
+    if (!m_delayed.empty()) {
+        d = static_cast<long>((m_delayed.begin()->first - now()) * 1000) + 1;
+    }
+    if (m_source != 0 && m_pending.empty()) {
+        d = d < 0 ? s_source_delay : std::min(d, s_source_delay);
+    }
+    return d;
+}
+
+void transfer_queue::release(slot* s)
+{
+    curl_multi_remove_handle(m_multi, s->m_handle);
+    rate_limiter::get().forget(s->m_handle);
+    m_pool.release(s->m_handle);
+    delete s;
+}
+
+}
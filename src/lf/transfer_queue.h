@@ -0,0 +1,218 @@
+#pragma once
+
+#include "responce_buffer.h"
+
+#include <base/exception.h>
+
+#include <curl/curl.h>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace lf {
+
+class connection_pool;
+class transfer_queue;
+
+/**
+ * @class transfer
+ * @brief Single request, which is executed by transfer_queue.
+ *
+ *        Derived classes configure the handle for their request and
+ *        handle the responce when the request is finished.
+ */
+class transfer
+{
+public:
+    /// @brief Destructor.
+    virtual ~transfer()
+    {
+    }
+
+public:
+    /**
+     * @brief Configures the given handle to perform the request.
+     * @param c CURL handle, which already has the common options of engine.
+     */
+    virtual void prepare(CURL* c) = 0;
+
+    /**
+     * @brief Handles the responce of finished request.
+     * @param r Responce body.
+     * @throw curl_error, request_error.
+     */
+    virtual void finish(const std::string& r) = 0;
+
+    /**
+     * @brief Handles the failure of request.
+     *
+     *        The handle of request is not released yet, so its status
+     *        can be read.
+     * @param r Error code of CURL.
+     * @throw curl_error.
+     */
+    virtual void fail(CURLcode r);
+
+    /**
+     * @brief Checks whether the failed transfer should be queued again.
+     *
+     *        Transfers which can be safely repeated override this to
+     *        retry themselves, instead of aborting the whole queue.
+     *        It is asked only for transient failures of retry_policy and
+     *        for the errors of finish, transfers which failed before their
+     *        request was sent are repeated anyway.
+     */
+    virtual bool retry()
+    {
+        return false;
+    }
+
+    /**
+     * @brief Handles the failure of transfer, which is not retried.
+     * @param e Error of transfer.
+     * @return True if failure is handled and the other transfers should
+     *         continue, false to abort the queue.
+     */
+    virtual bool give_up(const base::exception&)
+    {
+        return false;
+    }
+};
+
+/**
+ * @class transfer_source
+ * @brief Gives the transfers, which are not known when the queue starts.
+ */
+class transfer_source
+{
+public:
+    /// @brief Destructor.
+    virtual ~transfer_source()
+    {
+    }
+
+public:
+    /**
+     * @brief Pushes the transfers, which are ready, to the queue.
+     * @param q Queue.
+     * @return False if no more transfers will come.
+     */
+    virtual bool feed(transfer_queue& q) = 0;
+};
+
+/**
+ * @class transfer_queue
+ * @brief Executes queued transfers simultaneously by curl multi interface.
+ *
+ *        Every transfer gets its own copy of the given prototype handle,
+ *        so all the transfers share credentials and validation options.
+ *        Handles are taken from connection pool, so transfers reuse the
+ *        connections of engine. At most the given count of transfers run
+ *        at the same time. Transfers are multiplexed over HTTP/2
+ *        connections, and at most s_max_host_connections connections are
+ *        opened to one host, the other transfers wait for them. The other
+ *        transfers are started when the first one is connected, so they
+ *        are multiplexed over its connection instead of opening their own.
+ *        Repeated transfers wait for the backoff of retry_policy, while the
+ *        other transfers run.
+ */
+class transfer_queue
+{
+public:
+    /// @brief Maximal count of connections opened to one host.
+    static const long s_max_host_connections = 16;
+
+public:
+    /**
+     * @brief Constructor.
+     * @param p Connection pool.
+     * @param c Prototype handle for transfers.
+     * @param n Maximal count of simultaneous transfers.
+     * @param multiplex Multiplex transfers over one HTTP/2 connection,
+     *        otherwise every transfer has its own connection.
+     * @throw curl_error.
+     */
+    transfer_queue(connection_pool& p, CURL* c, unsigned n, bool multiplex = true);
+
+    /// @brief Destructor, aborts the unfinished transfers.
+    ~transfer_queue();
+
+private:
+    transfer_queue(const transfer_queue&);
+    transfer_queue& operator=(const transfer_queue&);
+
+public:
+    /**
+     * @brief Adds the transfer to the queue.
+     * @param t Transfer, queue takes the ownership of it.
+     */
+    void push(transfer* t);
+
+    /**
+     * @brief Adds the transfer to the front of queue, so it is started
+     *        before the already queued ones.
+     * @param t Transfer, queue takes the ownership of it.
+     */
+    void push_front(transfer* t);
+
+    /**
+     * @brief Sets the source of transfers, which is asked for more of them,
+     *        whenever the queue has no pending transfers, until it is
+     *        exhausted.
+     * @param s Source, which lives till the end of run.
+     */
+    void set_source(transfer_source* s);
+
+    /**
+     * @brief Runs all the queued transfers and waits for them.
+     *
+     *        transfer::finish is called in the order of completion.
+     *        Transfers can be pushed to the queue while it runs.
+     *        The first failure, which is neither retried nor given up by
+     *        its transfer, aborts the remaining transfers.
+     * @throw curl_error, request_error.
+     */
+    void run();
+
+    /**
+     * @brief Performs the request of single handle.
+     *
+     *        Without rate limits it is curl_easy_perform, otherwise the
+     *        handle is run by its own multi handle, so it is resumed as
+     *        soon as its bandwidth is available.
+     * @param c Handle.
+     * @return Result of request.
+     */
+    static CURLcode perform(CURL* c);
+
+private:
+    struct slot
+    {
+        CURL* m_handle;
+        transfer* m_transfer;
+        responce_buffer m_responce;
+    };
+
+    void start(transfer* t);
+    void done(CURL* c, CURLcode r);
+    void release(slot* s);
+    void postpone(transfer* t, curl_off_t retry_after);
+    void schedule();
+    long delay() const;
+
+private:
+    connection_pool& m_pool;
+    CURL* m_prototype;
+    CURLM* m_multi;
+    unsigned m_limit;
+    bool m_connected;
+    transfer_source* m_source;
+    std::deque<transfer*> m_pending;
+    std::vector<slot*> m_active;
+    std::multimap<double, transfer*> m_delayed;
+    std::map<transfer*, unsigned> m_failures;
+};
+
+}
@@ -4,6 +4,9 @@
 #include <ui/credentials.h>
 #include <ui/attach_command.h>
 #include <ui/attach_chunk_command.h>
+#include <ui/batch_command.h>
+#include <ui/daemon_client.h>
+#include <ui/daemon_command.h>
 #include <ui/delete_attachments_command.h>
 #include <ui/delete_filelink_command.h>
 #include <ui/download_command.h>
@@ -25,6 +28,8 @@ int main(int argc, char** argv)
     ui::credentials::init();
     p.register_command(new ui::attach_command(e));
     p.register_command(new ui::attach_chunk_command(e));
+    p.register_command(new ui::batch_command(p));
+    p.register_command(new ui::daemon_command(p));
     p.register_command(new ui::delete_attachments_command(e));
     p.register_command(new ui::delete_filelink_command(e));
     p.register_command(new ui::download_command(e));
@@ -47,5 +52,13 @@ int main(int argc, char** argv)
     for (int i = 2; i < argc; ++i) {
         args.push_back(argv[i]);
     }
-    return p.execute(c, args);
+    if (c != "daemon" && c != "batch" && c != "help") {
+        int r = ui::daemon_client::execute(c, args);
+        if (r >= 0) {
+            return r;
+        }
+    }
+    int r = p.execute(c, args);
+    e.report_statistics();
+    return r;
 }
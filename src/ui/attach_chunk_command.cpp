@@ -18,6 +18,10 @@ attach_chunk_command::attach_chunk_command(lf::engine& e)
 {
     get_arguments().push_back(credentials::get_arguments());
     get_arguments().push_back(s_report_level_arg);
+    get_arguments().push_back(s_timings_arg);
+    get_arguments().push_back(s_http_arg);
+    get_arguments().push_back(s_upload_buffer_arg);
+    get_arguments().push_back(s_upload_limit_arg);
     get_arguments().push_back(m_chunk_argument);
     get_arguments().push_back(m_chunks_argument);
     get_arguments().push_back(m_filename_argument);
@@ -26,6 +30,8 @@ attach_chunk_command::attach_chunk_command(lf::engine& e)
 
 void attach_chunk_command::execute(const cmd::arguments& args)
 {
+    timings t(args);
+    m_engine.set_http_version(s_http_arg.value(args));
     credentials c = credentials::manage(args);
     lf::report_level rl = s_report_level_arg.value(args);
     int chunk = m_chunk_argument.value(args);
@@ -35,6 +41,8 @@ void attach_chunk_command::execute(const cmd::arguments& args)
     if (unnamed_args.size() != 1) {
         throw cmd::invalid_arguments("Need to specify only one file.");
     }
+    m_engine.set_upload_buffer_size(upload_buffer_value(args));
+    set_rate_limits(args);
     m_engine.attach(c.server(), c.api_key(), *unnamed_args.begin(),
             filename, chunk, chunks, rl, c.validate_flag());
 }
@@ -11,19 +11,34 @@ namespace ui {
 attach_command::attach_command(lf::engine& e)
     : cmd::command("attach", "Uploads given files to server.")
     , m_engine(e)
-    , m_files_argument("<file> ...", "File path(s) to upload.")
+    , m_files_argument("<file> ...", "File or directory path(s) to upload.")
 {
     get_arguments().push_back(credentials::get_arguments());
     get_arguments().push_back(s_report_level_arg);
+    get_arguments().push_back(s_timings_arg);
+    get_arguments().push_back(s_http_arg);
+    get_arguments().push_back(s_parallel_arg);
+    get_arguments().push_back(s_chunk_size_arg);
+    get_arguments().push_back(s_upload_buffer_arg);
+    get_arguments().push_back(s_upload_limit_arg);
+    get_arguments().push_back(s_include_arg);
+    get_arguments().push_back(s_exclude_arg);
     get_arguments().push_back(m_files_argument);
 }
 
 void attach_command::execute(const cmd::arguments& args)
 {
+    timings t(args);
+    m_engine.set_http_version(s_http_arg.value(args));
     credentials c = credentials::manage(args);
     lf::report_level rl = s_report_level_arg.value(args);
+    unsigned p = parallel_value(args);
+    long long cs = chunk_size_value(args);
     std::set<std::string> unnamed_args = m_files_argument.value(args);
-    m_engine.attach(c.server(), c.api_key(), unnamed_args, rl, c.validate_flag());
+    m_engine.set_upload_buffer_size(upload_buffer_value(args));
+    set_rate_limits(args);
+    set_file_patterns(m_engine, args);
+    m_engine.attach(c.server(), c.api_key(), unnamed_args, p, cs, rl, c.validate_flag());
 }
 
 }
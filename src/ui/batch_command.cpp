@@ -0,0 +1,220 @@
+#include "batch_command.h"
+#include "common_arguments.h"
+
+#include <base/mutex.h>
+#include <base/thread.h>
+#include <cmd/command_processor.h>
+#include <cmd/exceptions.h>
+#include <cmd/utility.h>
+#include <io/messenger.h>
+#include <lf/exceptions.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace ui {
+
+batch_command::batch_command(cmd::command_processor& p)
+    : cmd::command("batch", "Executes commands read from files or standard input.")
+    , m_command_processor(p)
+    , m_jobs_argument("jobs", "<N>", "Count of commands to execute simultaneously.", 1)
+    , m_files_argument("<file> ...", "Files with one command per line, '-' for standard input.\n"
+        "\t    Standard input is read, if no file is specified.")
+{
+    get_arguments().push_back(m_jobs_argument);
+    get_arguments().push_back(s_upload_limit_arg);
+    get_arguments().push_back(s_download_limit_arg);
+    get_arguments().push_back(s_timings_arg);
+    get_arguments().push_back(m_files_argument);
+}
+
+namespace {
+
+struct batch_entry
+{
+    std::string m_line;
+    int m_status;
+};
+
+void read_commands(std::istream& s, std::vector<batch_entry>& es)
+{
+    std::string l;
+    while (std::getline(s, l)) {
+        std::string::size_type b = l.find_first_not_of(" \t\r");
+        if (b == std::string::npos || l[b] == '#') {
+            continue;
+        }
+        std::string::size_type e = l.find_last_not_of(" \t\r");
+        batch_entry x;
+        x.m_line = l.substr(b, e - b + 1);
+        x.m_status = 0;
+        es.push_back(x);
+    }
+}
+
+/**
+ * @brief Executes the commands of batch one by one, or by several workers,
+ *        each of them taking the next command which is not started yet.
+ *
+ *        Output of worker is collected while command is executed and is
+ *        printed as a whole, so outputs of simultaneous commands do not mix.
+ */
+class batch_runner
+{
+public:
+    batch_runner(cmd::command_processor& p, std::vector<batch_entry>& es)
+        : m_command_processor(p)
+        , m_entries(es)
+        , m_next(0)
+    {
+    }
+
+public:
+    void run(unsigned jobs)
+    {
+        if (jobs <= 1 || m_entries.size() <= 1) {
+            for (unsigned i = 0; i < m_entries.size(); ++i) {
+                execute(i);
+                report(i, "");
+            }
+            return;
+        }
+        std::vector<worker*> ws;
+        for (unsigned i = 0; i < jobs && i < m_entries.size(); ++i) {
+            worker* w = new worker(*this);
+            if (!w->start()) {
+                delete w;
+                break;
+            }
+            ws.push_back(w);
+        }
+        // Commands not taken by workers, if threads could not be created.
+        work();
+        for (unsigned i = 0; i < ws.size(); ++i) {
+            delete ws[i];
+        }
+    }
+
+private:
+    class worker : public base::thread
+    {
+    public:
+        worker(batch_runner& r)
+            : m_runner(r)
+        {
+        }
+
+    protected:
+        virtual void run()
+        {
+            m_runner.work();
+        }
+
+    private:
+        batch_runner& m_runner;
+    };
+
+    void work()
+    {
+        while (true) {
+            unsigned i = 0;
+            {
+                base::scoped_lock l(m_mutex);
+                if (m_next == m_entries.size()) {
+                    return;
+                }
+                i = m_next++;
+            }
+            std::string o;
+            {
+                io::capture c;
+                execute(i);
+                o = c.str();
+            }
+            base::scoped_lock l(m_mutex);
+            report(i, o);
+        }
+    }
+
+    void execute(unsigned i)
+    {
+        batch_entry& e = m_entries[i];
+        std::vector<std::string> args;
+        try {
+            cmd::utility::split_command_line(args, e.m_line);
+            if (args.front() == "batch" || args.front() == "daemon") {
+                throw cmd::invalid_arguments("Command '" + args.front()
+                        + "' can not be executed by batch.");
+            }
+        } catch (base::exception& x) {
+            io::mout << "Error: " << x.message() << io::endl;
+            e.m_status = x.code();
+            return;
+        }
+        std::string n = args.front();
+        args.erase(args.begin());
+        e.m_status = m_command_processor.execute(n, args);
+    }
+
+    void report(unsigned i, const std::string& o)
+    {
+        io::mout << o << "Command " << i + 1 << " exited with status "
+            << m_entries[i].m_status << ": " << m_entries[i].m_line << io::endl;
+    }
+
+private:
+    cmd::command_processor& m_command_processor;
+    std::vector<batch_entry>& m_entries;
+    unsigned m_next;
+    base::mutex m_mutex;
+};
+
+}
+
+void batch_command::execute(const cmd::arguments& args)
+{
+    timings t(args, true);
+    int jobs = m_jobs_argument.value(args);
+    if (jobs < 1) {
+        throw cmd::invalid_argument_value("--jobs", "positive integers");
+    }
+    set_shared_rate_limits(args);
+    // Files are read in the given order, a file given twice is read twice.
+    const std::vector<std::string>& fs = args.get_unnamed_argument_list();
+    std::vector<batch_entry> es;
+    if (fs.empty()) {
+        read_commands(std::cin, es);
+    }
+    std::vector<std::string>::const_iterator i = fs.begin();
+    for (; i != fs.end(); ++i) {
+        if (*i == "-") {
+            read_commands(std::cin, es);
+            continue;
+        }
+        std::ifstream f(i->c_str());
+        if (!f) {
+            throw lf::file_error(*i, std::strerror(errno));
+        }
+        read_commands(f, es);
+    }
+    batch_runner r(m_command_processor, es);
+    r.run(jobs);
+    unsigned failed = 0;
+    int status = 0;
+    std::vector<batch_entry>::const_iterator j = es.begin();
+    for (; j != es.end(); ++j) {
+        if (j->m_status != 0) {
+            if (failed++ == 0) {
+                status = j->m_status;
+            }
+        }
+    }
+    if (failed != 0) {
+        throw cmd::failed_commands(failed, es.size(), status);
+    }
+}
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cmd/command.h>
+
+namespace cmd {
+class command_processor;
+}
+
+namespace ui {
+
+/**
+ * @class batch_command.
+ * @brief Class for 'batch' command.
+ */
+class batch_command : public cmd::command
+{
+public:
+    /// @brief Constructor.
+    /// @param p Command processor to execute commands by.
+    batch_command(cmd::command_processor& p);
+
+public:
+    /// @brief Executes command by given arguments.
+    virtual void execute(const cmd::arguments& args);
+
+private:
+    cmd::command_processor& m_command_processor;
+    cmd::argument_definition<int, cmd::NAMED_ARGUMENT, false> m_jobs_argument;
+    cmd::argument_definition<std::string, cmd::UNNAMED_ARGUMENT, false> m_files_argument;
+};
+
+}
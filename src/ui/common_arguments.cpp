@@ -1,5 +1,13 @@
 #include "common_arguments.h"
 
+#include <lf/engine.h>
+#include <lf/rate_limiter.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
 namespace ui {
 
 cmd::argument_definition<lf::report_level, cmd::NAMED_ARGUMENT, false> s_report_level_arg
@@ -8,7 +16,213 @@ cmd::argument_definition<lf::report_level, cmd::NAMED_ARGUMENT, false> s_report_
 cmd::argument_definition<lf::output_format, cmd::NAMED_ARGUMENT, false> s_output_format_arg
     ("output_format", "<format>", "Specifies output string format.", lf::TABLE_FORMAT);
 
+cmd::argument_definition<int, cmd::NAMED_ARGUMENT, false> s_parallel_arg
+    ("parallel", "<N>", "Count of files to upload simultaneously.", 1);
+
+cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> s_chunk_size_arg
+    ("chunk_size", "<size>", "Size of chunks to upload larger files by."
+     " Can have K, M or G suffix, 0 disables chunked upload, 'auto' picks"
+     " the size by measured throughput of server.", "auto");
+
+cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> s_upload_buffer_arg
+    ("upload_buffer", "<size>", "Size of buffer to read uploaded files by."
+     " Can have K or M suffix, from 16K to 2M.", "1M");
+
+cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> s_upload_limit_arg
+    ("upload_limit", "<rate>", "Limit of upload bandwidth in bytes per second,"
+     " shared by all the uploads of process. Can have K, M or G suffix, 0 is"
+     " unlimited. Can be a comma separated list of HH:MM-HH:MM=<rate> periods"
+     " to limit by time of day.", "");
+
+cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> s_include_arg
+    ("include", "<patterns>", "Comma separated list of wildcards of files to"
+     " upload from the given directories. Pattern with '/' is matched against"
+     " the path in directory, otherwise against the name. All files are"
+     " uploaded if it is empty.", "");
+
+cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> s_exclude_arg
+    ("exclude", "<patterns>", "Comma separated list of wildcards of files and"
+     " subdirectories to skip in the given directories. Same format as"
+     " '--include'.", "");
+
+cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> s_download_limit_arg
+    ("download_limit", "<rate>", "Limit of download bandwidth in bytes per"
+     " second, shared by all the downloads of process. Same format as"
+     " '--upload_limit'.", "");
+
+cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> s_timings_arg
+    ("timings", "<file>", "File to append the timings of every request to."
+     " Lines are in JSON if file name ends with '.json' or '.jsonl',"
+     " otherwise in CSV.", "");
+
+cmd::argument_definition<lf::http_version, cmd::NAMED_ARGUMENT, false> s_http_arg
+    ("http", "<version>", "Version of HTTP. With 2, HTTP/2 is used with the"
+     " servers, which support it over TLS, and simultaneous requests share"
+     " one connection. Other servers are used by HTTP/1.1.", lf::HTTP_2);
+
 cmd::argument_definition<bool, cmd::BOOLEAN_ARGUMENT, false>  s_attachment_argument
     ("r", "If specified, it means that unnamed arguments are attachment IDs,"
      " otherwise they are file paths.");
+
+namespace {
+
+// Limits are set by batch or daemon for all the commands it executes.
+bool s_shared_rate_limits = false;
+
+long long size_value(const std::string& n, const std::string& v)
+{
+    char* e = 0;
+    long long s = std::strtoll(v.c_str(), &e, 10);
+    if (e == v.c_str() || s < 0) {
+        throw cmd::invalid_argument_value(n,
+                "non-negative integers with optional K, M or G suffix");
+    }
+    std::string suffix(e);
+    if (suffix == "K") {
+        s *= 1024;
+    } else if (suffix == "M") {
+        s *= 1024 * 1024;
+    } else if (suffix == "G") {
+        s *= 1024 * 1024 * 1024;
+    } else if (!suffix.empty()) {
+        throw cmd::invalid_argument_value(n,
+                "non-negative integers with optional K, M or G suffix");
+    }
+    return s;
+}
+
+bool parse_period(const std::string& v, int& b, int& e)
+{
+    int bh = 0;
+    int bm = 0;
+    int eh = 0;
+    int em = 0;
+    char c = 0;
+    if (std::sscanf(v.c_str(), "%d:%d-%d:%d%c", &bh, &bm, &eh, &em, &c) != 4) {
+        return false;
+    }
+    if (bh < 0 || bh > 24 || eh < 0 || eh > 24 || bm < 0 || bm > 59
+            || em < 0 || em > 59) {
+        return false;
+    }
+    b = (bh * 60 + bm) % (24 * 60);
+    e = (eh * 60 + em) % (24 * 60);
+    return true;
+}
+
+lf::rate_limiter::profile rate_profile(const std::string& n, const std::string& v)
+{
+    lf::rate_limiter::profile p;
+    if (v.find('=') == std::string::npos) {
+        long long r = size_value(n, v);
+        if (r != 0) {
+            p.push_back(lf::rate_limiter::period(0, 24 * 60, r));
+        }
+        return p;
+    }
+    std::string::size_type i = 0;
+    while (i <= v.size()) {
+        std::string::size_type j = std::min(v.find(',', i), v.size());
+        std::string x = v.substr(i, j - i);
+        std::string::size_type k = x.find('=');
+        int b = 0;
+        int e = 0;
+        if (k == std::string::npos || !parse_period(x.substr(0, k), b, e)) {
+            throw cmd::invalid_argument_value(n,
+                    "rates or comma separated lists of HH:MM-HH:MM=<rate>");
+        }
+        if (b == e) {
+            b = 0;
+            e = 24 * 60;
+        }
+        p.push_back(lf::rate_limiter::period(b, e, size_value(n, x.substr(k + 1))));
+        i = j + 1;
+    }
+    return p;
+}
+
+}
+
+long long chunk_size_value(const cmd::arguments& a)
+{
+    std::string v = s_chunk_size_arg.value(a);
+    return v == "auto" ? -1 : size_value("--chunk_size", v);
+}
+
+long upload_buffer_value(const cmd::arguments& a)
+{
+    long long s = size_value("--upload_buffer", s_upload_buffer_arg.value(a));
+    if (s < 16 * 1024 || s > 2 * 1024 * 1024) {
+        throw cmd::invalid_argument_value("--upload_buffer", "sizes from 16K to 2M");
+    }
+    return static_cast<long>(s);
+}
+
+void set_rate_limits(const cmd::arguments& a)
+{
+    std::string u = s_upload_limit_arg.value(a);
+    std::string d = s_download_limit_arg.value(a);
+    if (s_shared_rate_limits && !(u.empty() && d.empty())) {
+        throw cmd::invalid_arguments("Bandwidth limits of batch or daemon "
+                "are shared by all its commands, they can't be changed by a command.");
+    }
+    if (!u.empty()) {
+        lf::rate_limiter::get().set_profile(lf::rate_limiter::UPLOAD,
+                rate_profile("--upload_limit", u));
+    }
+    if (!d.empty()) {
+        lf::rate_limiter::get().set_profile(lf::rate_limiter::DOWNLOAD,
+                rate_profile("--download_limit", d));
+    }
+}
+
+void set_shared_rate_limits(const cmd::arguments& a)
+{
+    set_rate_limits(a);
+    s_shared_rate_limits = true;
+}
+
+void set_file_patterns(lf::engine& e, const cmd::arguments& a)
+{
+    std::vector<std::string> ps[2];
+    std::string vs[2] = { s_include_arg.value(a), s_exclude_arg.value(a) };
+    for (int k = 0; k < 2; ++k) {
+        std::string::size_type i = 0;
+        while (i < vs[k].size()) {
+            std::string::size_type j = std::min(vs[k].find(',', i), vs[k].size());
+            if (j > i) {
+                ps[k].push_back(vs[k].substr(i, j - i));
+            }
+            i = j + 1;
+        }
+    }
+    e.set_file_patterns(ps[0], ps[1]);
+}
+
+timings::timings(const cmd::arguments& a, bool process)
+    : m_log(0)
+    , m_scope(0)
+    , m_process(process)
+{
+    std::string f = s_timings_arg.value(a);
+    if (f.empty()) {
+        return;
+    }
+    m_log = new lf::timing_log(f);
+    if (m_process) {
+        lf::timing_log::set_default(m_log);
+    } else {
+        m_scope = new lf::timing_log::scope(m_log);
+    }
+}
+
+timings::~timings()
+{
+    if (m_process && m_log != 0) {
+        lf::timing_log::set_default(0);
+    }
+    delete m_scope;
+    delete m_log;
+}
+
 }
@@ -3,6 +3,11 @@
 #include <cmd/argument_definition.h>
 #include <cmd/exceptions.h>
 #include <lf/declarations.h>
+#include <lf/timing_log.h>
+
+namespace lf {
+class engine;
+}
 
 namespace cmd {
 
@@ -74,12 +79,137 @@ inline std::string possible_values<lf::output_format>()
     return "Valid values: table, csv.";
 }
 
+template <>
+inline lf::http_version string_to_val(const std::string& v)
+{
+    if (v == "2") {
+        return lf::HTTP_2;
+    } else if (v == "1.1") {
+        return lf::HTTP_1_1;
+    }
+    throw cmd::invalid_argument_value("--http", "2, 1.1");
+}
+
+template <>
+inline std::string val_to_string(const lf::http_version& v)
+{
+    switch(v) {
+        case lf::HTTP_2 :
+            return "2";
+        case lf::HTTP_1_1 :
+            return "1.1";
+        default :
+            throw 1;
+    }
+    return "";
+}
+
+template <>
+inline std::string possible_values<lf::http_version>()
+{
+    return "Valid values: 2, 1.1.";
+}
+
 }
 
 namespace ui {
 
 extern cmd::argument_definition<lf::report_level, cmd::NAMED_ARGUMENT, false> s_report_level_arg;
 extern cmd::argument_definition<lf::output_format, cmd::NAMED_ARGUMENT, false> s_output_format_arg;
+extern cmd::argument_definition<int, cmd::NAMED_ARGUMENT, false> s_parallel_arg;
+extern cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> s_chunk_size_arg;
+extern cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> s_upload_buffer_arg;
+extern cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> s_upload_limit_arg;
+extern cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> s_include_arg;
+extern cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> s_exclude_arg;
+extern cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> s_download_limit_arg;
+extern cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> s_timings_arg;
+extern cmd::argument_definition<lf::http_version, cmd::NAMED_ARGUMENT, false> s_http_arg;
 extern cmd::argument_definition<bool, cmd::BOOLEAN_ARGUMENT, false> s_attachment_argument;
 
+/**
+ * @brief Gets the value of '--parallel' argument.
+ * @param a Arguments.
+ * @throw invalid_argument_value.
+ */
+inline unsigned parallel_value(const cmd::arguments& a)
+{
+    int p = s_parallel_arg.value(a);
+    if (p < 1) {
+        throw cmd::invalid_argument_value("--parallel", "positive integers");
+    }
+    return p;
+}
+
+/**
+ * @brief Gets the value of '--chunk_size' argument in bytes, -1 for 'auto'.
+ * @param a Arguments.
+ * @throw invalid_argument_value.
+ */
+long long chunk_size_value(const cmd::arguments& a);
+
+/**
+ * @brief Gets the value of '--upload_buffer' argument in bytes.
+ * @param a Arguments.
+ * @throw invalid_argument_value.
+ */
+long upload_buffer_value(const cmd::arguments& a);
+
+/**
+ * @brief Sets the bandwidth limits of process from '--upload_limit' and
+ *        '--download_limit' arguments, which are given.
+ * @param a Arguments.
+ * @throw invalid_argument_value, invalid_arguments if the limits are
+ *        shared by batch or daemon.
+ */
+void set_rate_limits(const cmd::arguments& a);
+
+/**
+ * @brief Sets the bandwidth limits of batch or daemon, which are shared by
+ *        all the commands it executes. Commands can't give their own limits
+ *        after that.
+ * @param a Arguments.
+ * @throw invalid_argument_value.
+ */
+void set_shared_rate_limits(const cmd::arguments& a);
+
+/**
+ * @brief Sets the patterns of files to upload from directories, for the
+ *        operations of calling thread, from '--include' and '--exclude'
+ *        arguments.
+ * @param e Engine.
+ * @param a Arguments.
+ */
+void set_file_patterns(lf::engine& e, const cmd::arguments& a);
+
+/**
+ * @class timings
+ * @brief Writes the timings of requests to the file given by '--timings',
+ *        while the object lives.
+ */
+class timings
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param a Arguments.
+     * @param process Write the requests of all the threads, which have no
+     *        log of their own, otherwise only of calling thread.
+     * @throw file_error.
+     */
+    timings(const cmd::arguments& a, bool process = false);
+
+    /// @brief Destructor.
+    ~timings();
+
+private:
+    timings(const timings&);
+    timings& operator=(const timings&);
+
+private:
+    lf::timing_log* m_log;
+    lf::timing_log::scope* m_scope;
+    bool m_process;
+};
+
 }
@@ -0,0 +1,46 @@
+#include "daemon_client.h"
+#include "daemon_protocol.h"
+
+#include <base/string.h>
+#include <io/messenger.h>
+
+#include <unistd.h>
+
+namespace ui {
+
+int daemon_client::execute(const std::string& c, const std::vector<std::string>& args)
+{
+    int fd = daemon_protocol::connect_to(daemon_protocol::socket_path());
+    if (fd < 0) {
+        return -1;
+    }
+    char d[4096];
+    bool ok = getcwd(d, sizeof(d)) != 0
+        && daemon_protocol::write_frame(fd, daemon_protocol::DIRECTORY_FRAME, d)
+        && daemon_protocol::write_frame(fd, daemon_protocol::ARGUMENT_FRAME, c);
+    std::vector<std::string>::const_iterator i = args.begin();
+    for (; ok && i != args.end(); ++i) {
+        ok = daemon_protocol::write_frame(fd, daemon_protocol::ARGUMENT_FRAME, *i);
+    }
+    ok = ok && daemon_protocol::write_frame(fd, daemon_protocol::RUN_FRAME, "");
+    if (!ok) {
+        // Daemon does not accept commands, execute it locally.
+        close(fd);
+        return -1;
+    }
+    char t = 0;
+    std::string f;
+    while (daemon_protocol::read_frame(fd, t, f)) {
+        if (t == daemon_protocol::OUTPUT_FRAME) {
+            io::mout.stream().write(f.data(), f.size()).flush();
+        } else if (t == daemon_protocol::EXIT_FRAME) {
+            close(fd);
+            return base::from_string<int>(f);
+        }
+    }
+    close(fd);
+    io::mout << "Error: Connection to daemon is lost." << io::endl;
+    return 1;
+}
+
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace ui {
+
+/**
+ * @class daemon_client
+ * @brief Forwards command to the running daemon, instead of executing it.
+ */
+class daemon_client
+{
+public:
+    /**
+     * @brief Executes the command by daemon and prints its output.
+     * @param c Command name.
+     * @param args Arguments of command.
+     * @return Exit status of command or -1 if daemon is not running.
+     */
+    static int execute(const std::string& c, const std::vector<std::string>& args);
+};
+
+}
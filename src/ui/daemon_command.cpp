@@ -0,0 +1,339 @@
+#include "daemon_command.h"
+#include "common_arguments.h"
+#include "daemon_protocol.h"
+
+#include <base/mutex.h>
+#include <base/string.h>
+#include <base/thread.h>
+#include <cmd/command_processor.h>
+#include <cmd/exceptions.h>
+#include <io/messenger.h>
+#include <lf/exceptions.h>
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ui {
+
+daemon_command::daemon_command(cmd::command_processor& p)
+    : cmd::command("daemon", "Executes commands sent by clients over Unix domain socket.")
+    , m_command_processor(p)
+    , m_socket_argument("socket", "<path>", "Path of socket to listen.\n"
+        "\t    If not specified, LIQUIDFILES_SOCKET environment variable or\n"
+        "\t    '~/.liquidfiles/daemon.sock' is used.")
+    , m_jobs_argument("jobs", "<N>", "Count of commands to execute simultaneously.", 4)
+{
+    get_arguments().push_back(m_socket_argument);
+    get_arguments().push_back(m_jobs_argument);
+    get_arguments().push_back(s_upload_limit_arg);
+    get_arguments().push_back(s_download_limit_arg);
+    get_arguments().push_back(s_timings_arg);
+}
+
+namespace {
+
+// Time to wait for the client to send the whole command.
+const long s_request_timeout = 10;
+
+struct request
+{
+    request(int fd)
+        : m_fd(fd)
+        , m_bulk(false)
+        , m_read(false)
+    {
+    }
+
+    int m_fd;
+    std::string m_directory;
+    std::vector<std::string> m_args;
+    bool m_bulk;
+    bool m_read;
+};
+
+/**
+ * @brief Checks whether command transfers files, which may take long time.
+ */
+bool is_bulk(const std::string& c)
+{
+    static const char* names[] = { "attach", "attach_chunk", "download",
+        "filedrop", "filelink", "send" };
+    for (unsigned i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        if (c == names[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Reads the command from the socket of request, the socket is closed
+ *        if the command is not valid or is not sent in time.
+ */
+bool read_request(request& r)
+{
+    timeval t = { s_request_timeout, 0 };
+    setsockopt(r.m_fd, SOL_SOCKET, SO_RCVTIMEO, &t, sizeof(t));
+    char c = 0;
+    std::string d;
+    while (daemon_protocol::read_frame(r.m_fd, c, d)) {
+        if (c == daemon_protocol::DIRECTORY_FRAME) {
+            r.m_directory = d;
+        } else if (c == daemon_protocol::ARGUMENT_FRAME) {
+            r.m_args.push_back(d);
+        } else if (c == daemon_protocol::RUN_FRAME && !r.m_args.empty()) {
+            r.m_bulk = is_bulk(r.m_args.front());
+            r.m_read = true;
+            t.tv_sec = 0;
+            setsockopt(r.m_fd, SOL_SOCKET, SO_RCVTIMEO, &t, sizeof(t));
+            return true;
+        } else {
+            break;
+        }
+    }
+    close(r.m_fd);
+    return false;
+}
+
+/**
+ * @class scheduler
+ * @brief Queue of requests with two priority lanes.
+ *
+ *        Requests which transfer files go to the bulk lane, other ones go to
+ *        the interactive lane. Interactive requests are taken first, and bulk
+ *        requests never occupy all the workers, so listing of messages is
+ *        not stuck behind large uploads. Accepted connections, which command
+ *        is not read yet, go to the interactive lane.
+ */
+class scheduler
+{
+public:
+    scheduler(unsigned n)
+        : m_bulk_limit(n > 1 ? n - 1 : 1)
+        , m_bulk_running(0)
+    {
+    }
+
+public:
+    void push(request* r)
+    {
+        base::scoped_lock l(m_mutex);
+        if (r->m_bulk) {
+            m_bulk.push_back(r);
+        } else {
+            m_interactive.push_back(r);
+        }
+        m_condition.broadcast();
+    }
+
+    request* pop()
+    {
+        base::scoped_lock l(m_mutex);
+        while (true) {
+            if (!m_interactive.empty()) {
+                request* r = m_interactive.front();
+                m_interactive.pop_front();
+                return r;
+            }
+            if (!m_bulk.empty() && m_bulk_running < m_bulk_limit) {
+                request* r = m_bulk.front();
+                m_bulk.pop_front();
+                ++m_bulk_running;
+                return r;
+            }
+            m_condition.wait(m_mutex);
+        }
+    }
+
+    void done(request* r)
+    {
+        base::scoped_lock l(m_mutex);
+        if (r->m_bulk) {
+            --m_bulk_running;
+            m_condition.broadcast();
+        }
+    }
+
+private:
+    unsigned m_bulk_limit;
+    unsigned m_bulk_running;
+    std::deque<request*> m_interactive;
+    std::deque<request*> m_bulk;
+    base::mutex m_mutex;
+    base::condition m_condition;
+};
+
+/**
+ * @class worker
+ * @brief Executes requests and sends their output to clients.
+ *
+ *        On Linux every worker has its own working directory, so relative
+ *        paths in commands are resolved from the directory of client.
+ *        Worker, which can't have its own directory, rejects the commands,
+ *        so their paths are not resolved from the directory of daemon.
+ */
+class worker : public base::thread
+{
+public:
+    worker(cmd::command_processor& p, scheduler& s)
+        : m_command_processor(p)
+        , m_scheduler(s)
+        , m_own_directory(false)
+    {
+    }
+
+protected:
+    virtual void run()
+    {
+#ifdef CLONE_FS
+        m_own_directory = unshare(CLONE_FS) == 0;
+#endif
+        while (true) {
+            request* r = m_scheduler.pop();
+            if (!r->m_read) {
+                // Command is read by worker, so a slow client does not hold
+                // the accepting of other clients.
+                if (!read_request(*r)) {
+                    delete r;
+                    continue;
+                }
+                if (r->m_bulk) {
+                    m_scheduler.push(r);
+                    continue;
+                }
+            }
+            serve(*r);
+            m_scheduler.done(r);
+            delete r;
+        }
+    }
+
+private:
+    void serve(request& r)
+    {
+        daemon_protocol::frame_ostream o(r.m_fd);
+        io::mout.redirect(&o);
+        int status = 0;
+        std::string c = r.m_args.front();
+        r.m_args.erase(r.m_args.begin());
+        if (c == "daemon" || c == "batch") {
+            io::mout << "Error: Command '" << c << "' can not be executed by daemon." << io::endl;
+            status = 1;
+        } else if (!m_own_directory) {
+            io::mout << "Error: Daemon can't execute commands in the directory of client."
+                << io::endl;
+            status = 5;
+        } else if (chdir(r.m_directory.c_str()) != 0) {
+            io::mout << "Error: Can't change directory to '" << r.m_directory
+                << "'. " << std::strerror(errno) << io::endl;
+            status = 5;
+        } else {
+            status = m_command_processor.execute(c, r.m_args);
+        }
+        io::mout.redirect(0);
+        o.flush();
+        daemon_protocol::write_frame(r.m_fd, daemon_protocol::EXIT_FRAME,
+                base::to_string(status));
+        close(r.m_fd);
+    }
+
+private:
+    cmd::command_processor& m_command_processor;
+    scheduler& m_scheduler;
+    bool m_own_directory;
+};
+
+int listen_to(const std::string& p)
+{
+    sockaddr_un a;
+    if (p.size() >= sizeof(a.sun_path)) {
+        throw cmd::invalid_argument_value("--socket", "paths shorter than "
+                + base::to_string(sizeof(a.sun_path)) + " characters");
+    }
+    int fd = daemon_protocol::connect_to(p);
+    if (fd >= 0) {
+        close(fd);
+        throw cmd::invalid_arguments("Daemon is already running on '" + p + "'.");
+    }
+    std::string::size_type s = p.rfind('/');
+    if (s != std::string::npos && s != 0) {
+        mkdir(p.substr(0, s).c_str(), S_IRWXU);
+    }
+    unlink(p.c_str());
+    std::memset(&a, 0, sizeof(a));
+    a.sun_family = AF_UNIX;
+    std::strcpy(a.sun_path, p.c_str());
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&a), sizeof(a)) != 0
+            || chmod(p.c_str(), S_IRUSR | S_IWUSR) != 0 || listen(fd, SOMAXCONN) != 0) {
+        std::string e = std::strerror(errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        throw lf::file_error(p, e);
+    }
+    return fd;
+}
+
+}
+
+void daemon_command::execute(const cmd::arguments& args)
+{
+    timings t(args, true);
+    int jobs = m_jobs_argument.value(args);
+    if (jobs < 1) {
+        throw cmd::invalid_argument_value("--jobs", "positive integers");
+    }
+    set_shared_rate_limits(args);
+    std::string p = m_socket_argument.value(args);
+    if (p.empty()) {
+        p = daemon_protocol::socket_path();
+    }
+    int fd = listen_to(p);
+    scheduler s(jobs);
+    std::vector<worker*> ws;
+    for (int i = 0; i < jobs; ++i) {
+        worker* w = new worker(m_command_processor, s);
+        if (!w->start()) {
+            delete w;
+            break;
+        }
+        ws.push_back(w);
+    }
+    if (ws.empty()) {
+        close(fd);
+        unlink(p.c_str());
+        throw cmd::invalid_arguments("Failed to start workers of daemon.");
+    }
+    io::mout << "Daemon is listening on '" << p << "'." << io::endl;
+    while (true) {
+        int c = accept(fd, 0, 0);
+        if (c < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno == EMFILE || errno == ENFILE) {
+                // Wait for the running commands to close their sockets.
+                usleep(100 * 1000);
+                continue;
+            }
+            break;
+        }
+        s.push(new request(c));
+    }
+    std::string e = std::strerror(errno);
+    close(fd);
+    unlink(p.c_str());
+    throw lf::file_error(p, e);
+}
+
+}
@@ -0,0 +1,150 @@
+#include "daemon_protocol.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ui {
+
+namespace daemon_protocol {
+
+namespace {
+
+// Frames larger than this are treated as broken.
+const uint32_t s_max_frame_size = 16 * 1024 * 1024;
+
+bool write_all(int fd, const char* d, size_t n)
+{
+    while (n > 0) {
+        ssize_t k = send(fd, d, n, MSG_NOSIGNAL);
+        if (k < 0 && errno == EINTR) {
+            continue;
+        }
+        if (k <= 0) {
+            return false;
+        }
+        d += k;
+        n -= k;
+    }
+    return true;
+}
+
+bool read_all(int fd, char* d, size_t n)
+{
+    while (n > 0) {
+        ssize_t k = recv(fd, d, n, 0);
+        if (k < 0 && errno == EINTR) {
+            continue;
+        }
+        if (k <= 0) {
+            return false;
+        }
+        d += k;
+        n -= k;
+    }
+    return true;
+}
+
+}
+
+std::string socket_path()
+{
+    const char* s = std::getenv("LIQUIDFILES_SOCKET");
+    if (s != 0 && *s != 0) {
+        return s;
+    }
+    const char* h = std::getenv("HOME");
+    return std::string(h == 0 ? "" : h) + "/.liquidfiles/daemon.sock";
+}
+
+int connect_to(const std::string& p)
+{
+    sockaddr_un a;
+    if (p.size() >= sizeof(a.sun_path)) {
+        return -1;
+    }
+    std::memset(&a, 0, sizeof(a));
+    a.sun_family = AF_UNIX;
+    std::strcpy(a.sun_path, p.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&a), sizeof(a)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool write_frame(int fd, char t, const std::string& d)
+{
+    char h[5];
+    h[0] = t;
+    uint32_t n = htonl(static_cast<uint32_t>(d.size()));
+    std::copy(reinterpret_cast<char*>(&n), reinterpret_cast<char*>(&n) + 4, h + 1);
+    return write_all(fd, h, sizeof(h)) && write_all(fd, d.data(), d.size());
+}
+
+bool read_frame(int fd, char& t, std::string& d)
+{
+    char h[5];
+    if (!read_all(fd, h, sizeof(h))) {
+        return false;
+    }
+    uint32_t n = 0;
+    std::copy(h + 1, h + 5, reinterpret_cast<char*>(&n));
+    n = ntohl(n);
+    if (n > s_max_frame_size) {
+        return false;
+    }
+    t = h[0];
+    d.resize(n);
+    return n == 0 || read_all(fd, &d[0], n);
+}
+
+frame_ostream::buffer::buffer(int fd)
+    : m_fd(fd)
+{
+    setp(m_data, m_data + sizeof(m_data));
+}
+
+frame_ostream::buffer::int_type frame_ostream::buffer::overflow(int_type c)
+{
+    if (sync() != 0) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int frame_ostream::buffer::sync()
+{
+    if (pptr() == pbase()) {
+        return 0;
+    }
+    std::string d(pbase(), pptr());
+    setp(m_data, m_data + sizeof(m_data));
+    return write_frame(m_fd, OUTPUT_FRAME, d) ? 0 : -1;
+}
+
+frame_ostream::frame_ostream(int fd)
+    : std::ostream(0)
+    , m_buffer(fd)
+{
+    rdbuf(&m_buffer);
+}
+
+}
+
+}
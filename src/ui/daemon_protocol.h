@@ -0,0 +1,95 @@
+#pragma once
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+namespace ui {
+
+/**
+ * @brief Protocol between daemon and its clients.
+ *
+ *        Client and daemon exchange frames over Unix domain socket. Every
+ *        frame is a type byte, 4 bytes of data size in network order and
+ *        data. Client sends its working directory, the arguments of command
+ *        and the run frame. Daemon sends the output of command while it is
+ *        executed and the exit frame with exit status of command.
+ */
+namespace daemon_protocol {
+
+enum frame_type {
+    DIRECTORY_FRAME = 'd',
+    ARGUMENT_FRAME = 'a',
+    RUN_FRAME = 'r',
+    OUTPUT_FRAME = 'o',
+    EXIT_FRAME = 'x'
+};
+
+/**
+ * @brief Gets the path of daemon socket.
+ *
+ *        It is taken from LIQUIDFILES_SOCKET environment variable, if it is
+ *        set, otherwise '~/.liquidfiles/daemon.sock' is used.
+ */
+std::string socket_path();
+
+/**
+ * @brief Connects to the Unix domain socket.
+ * @param p Path of socket.
+ * @return Connected socket or -1 if nobody listens on it.
+ */
+int connect_to(const std::string& p);
+
+/**
+ * @brief Writes the frame to socket.
+ * @param fd Socket.
+ * @param t Type of frame.
+ * @param d Data of frame.
+ * @return False if socket is closed.
+ */
+bool write_frame(int fd, char t, const std::string& d);
+
+/**
+ * @brief Reads the frame from socket.
+ * @param fd Socket.
+ * @param t Type of frame.
+ * @param d Data of frame.
+ * @return False if socket is closed or frame is broken.
+ */
+bool read_frame(int fd, char& t, std::string& d);
+
+/**
+ * @class frame_ostream
+ * @brief Stream which sends written data to socket by output frames.
+ *
+ *        Data is sent when stream is flushed, so every line written by
+ *        io::endl reaches the client at once.
+ */
+class frame_ostream : public std::ostream
+{
+public:
+    /// @brief Constructor.
+    /// @param fd Socket.
+    frame_ostream(int fd);
+
+private:
+    class buffer : public std::streambuf
+    {
+    public:
+        buffer(int fd);
+
+    protected:
+        virtual int_type overflow(int_type c);
+        virtual int sync();
+
+    private:
+        int m_fd;
+        char m_data[4096];
+    };
+
+    buffer m_buffer;
+};
+
+}
+
+}
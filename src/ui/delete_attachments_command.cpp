@@ -16,12 +16,16 @@ delete_attachments_command::delete_attachments_command(lf::engine& e)
 {
     get_arguments().push_back(credentials::get_arguments());
     get_arguments().push_back(s_report_level_arg);
+    get_arguments().push_back(s_timings_arg);
+    get_arguments().push_back(s_http_arg);
     get_arguments().push_back(m_message_id_argument);
     get_arguments().push_back(m_attachment_ids_argument);
 }
 
 void delete_attachments_command::execute(const cmd::arguments& args)
 {
+    timings t(args);
+    m_engine.set_http_version(s_http_arg.value(args));
     credentials c = credentials::manage(args);
     lf::report_level rl = s_report_level_arg.value(args);
     std::string id = m_message_id_argument.value(args);
@@ -15,11 +15,15 @@ delete_filelink_command::delete_filelink_command(lf::engine& e)
 {
     get_arguments().push_back(credentials::get_arguments());
     get_arguments().push_back(s_report_level_arg);
+    get_arguments().push_back(s_timings_arg);
+    get_arguments().push_back(s_http_arg);
     get_arguments().push_back(m_filelink_id_argument);
 }
 
 void delete_filelink_command::execute(const cmd::arguments& args)
 {
+    timings t(args);
+    m_engine.set_http_version(s_http_arg.value(args));
     credentials c = credentials::manage(args);
     lf::report_level rl = s_report_level_arg.value(args);
     std::string id = m_filelink_id_argument.value(args);
@@ -15,19 +15,28 @@ download_command::download_command(lf::engine& e)
     , m_message_id_argument("message_id", "<id>", "Message id to download attachments of it.")
     , m_sent_in_last_argument("sent_in_the_last", "<HOURS>", "Download files sent in the last specified hours.")
     , m_sent_after_argument("sent_after", "YYYYMMDD", "Download files sent after specified date.")
+    , m_parallel_argument("parallel", "<N>", "Count of files to download simultaneously.", 4)
+    , m_segments_argument("segments", "<N>", "Count of connections to download a large file by.", 1)
     , m_urls_argument("<url> ...", "Url(s) of files to download.")
 {
     get_arguments().push_back(credentials::get_arguments());
     get_arguments().push_back(s_report_level_arg);
+    get_arguments().push_back(s_timings_arg);
+    get_arguments().push_back(s_http_arg);
     get_arguments().push_back(m_path_argument);
     get_arguments().push_back(m_message_id_argument);
     get_arguments().push_back(m_sent_in_last_argument);
     get_arguments().push_back(m_sent_after_argument);
+    get_arguments().push_back(m_parallel_argument);
+    get_arguments().push_back(m_segments_argument);
+    get_arguments().push_back(s_download_limit_arg);
     get_arguments().push_back(m_urls_argument);
 }
 
 void download_command::execute(const cmd::arguments& args)
 {
+    timings t(args);
+    m_engine.set_http_version(s_http_arg.value(args));
     credentials c;
     try {
         c = credentials::manage(args);
@@ -42,15 +51,24 @@ void download_command::execute(const cmd::arguments& args)
     std::string f = m_sent_after_argument.value(args);
     std::string id = m_message_id_argument.value(args);
     std::set<std::string> unnamed_args = m_urls_argument.value(args);
+    int p = m_parallel_argument.value(args);
+    if (p < 1) {
+        throw cmd::invalid_argument_value("--parallel", "positive integers");
+    }
+    int n = m_segments_argument.value(args);
+    if (n < 1) {
+        throw cmd::invalid_argument_value("--segments", "positive integers");
+    }
+    set_rate_limits(args);
     if (!c.server().empty()) {
         if (!id.empty()) {
-            m_engine.download(c.server(), c.api_key(), path, id, rl, c.validate_flag());
+            m_engine.download(c.server(), c.api_key(), path, id, n, p, rl, c.validate_flag());
         }
         if (!l.empty() || !f.empty()) {
-            m_engine.download(c.server(), c.api_key(), path, l, f, rl, c.validate_flag());
+            m_engine.download(c.server(), c.api_key(), path, l, f, n, p, rl, c.validate_flag());
         }
     }
-    m_engine.download(unnamed_args, c.api_key(), path, rl, c.validate_flag());
+    m_engine.download(unnamed_args, c.api_key(), path, n, p, rl, c.validate_flag());
 }
 
 }
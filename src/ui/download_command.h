@@ -29,6 +29,8 @@ private:
     cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> m_message_id_argument;
     cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> m_sent_in_last_argument;
     cmd::argument_definition<std::string, cmd::NAMED_ARGUMENT, false> m_sent_after_argument;
+    cmd::argument_definition<int, cmd::NAMED_ARGUMENT, false> m_parallel_argument;
+    cmd::argument_definition<int, cmd::NAMED_ARGUMENT, false> m_segments_argument;
     cmd::argument_definition<std::string, cmd::UNNAMED_ARGUMENT, false> m_urls_argument;
 };
 
@@ -17,6 +17,8 @@ file_request_command::file_request_command(lf::engine& e)
 {
     get_arguments().push_back(credentials::get_arguments());
     get_arguments().push_back(s_report_level_arg);
+    get_arguments().push_back(s_timings_arg);
+    get_arguments().push_back(s_http_arg);
     get_arguments().push_back(m_to_argument);
     get_arguments().push_back(m_subject_argument);
     get_arguments().push_back(m_message_argument);
@@ -24,6 +26,8 @@ file_request_command::file_request_command(lf::engine& e)
 
 void file_request_command::execute(const cmd::arguments& args)
 {
+    timings t(args);
+    m_engine.set_http_version(s_http_arg.value(args));
     credentials c = credentials::manage(args);
     std::string user = m_to_argument.value(args);
     lf::report_level rl = s_report_level_arg.value(args);
@@ -16,11 +16,19 @@ filedrop_command::filedrop_command(lf::engine& e)
     , m_from_argument("from", "<username>", "User who sends the files")
     , m_message_argument("message", "<string>", "Message text of composed email.", "")
     , m_subject_argument("subject", "<string>", "Subject of composed email.", "")
-    , m_files_argument("<file> ...", "File path(s) or attachments IDs to send to user.")
+    , m_files_argument("<file> ...", "File or directory path(s) or attachments IDs to send to user.")
 {
     get_arguments().push_back(m_server_arg);
     get_arguments().push_back(m_validate_cert_arg);
     get_arguments().push_back(s_report_level_arg);
+    get_arguments().push_back(s_timings_arg);
+    get_arguments().push_back(s_http_arg);
+    get_arguments().push_back(s_parallel_arg);
+    get_arguments().push_back(s_chunk_size_arg);
+    get_arguments().push_back(s_upload_buffer_arg);
+    get_arguments().push_back(s_upload_limit_arg);
+    get_arguments().push_back(s_include_arg);
+    get_arguments().push_back(s_exclude_arg);
     get_arguments().push_back(m_from_argument);
     get_arguments().push_back(m_subject_argument);
     get_arguments().push_back(m_message_argument);
@@ -30,6 +38,8 @@ filedrop_command::filedrop_command(lf::engine& e)
 
 void filedrop_command::execute(const cmd::arguments& args)
 {
+    timings t(args);
+    m_engine.set_http_version(s_http_arg.value(args));
     std::string server = m_server_arg.value(args);
     lf::validate_cert k = m_validate_cert_arg.value(args);
     lf::report_level rl = s_report_level_arg.value(args);
@@ -38,10 +48,15 @@ void filedrop_command::execute(const cmd::arguments& args)
     std::string message = m_message_argument.value(args);
     std::set<std::string> unnamed_args = m_files_argument.value(args);
     bool r = s_attachment_argument.value(args);
+    unsigned p = parallel_value(args);
+    long long cs = chunk_size_value(args);
+    m_engine.set_upload_buffer_size(upload_buffer_value(args));
+    set_rate_limits(args);
+    set_file_patterns(m_engine, args);
     if (r) {
         m_engine.filedrop_attachments(server, user, subject, message, unnamed_args, rl, k);
     } else {
-        m_engine.filedrop(server, user, subject, message, unnamed_args, rl, k);
+        m_engine.filedrop(server, user, subject, message, unnamed_args, p, cs, rl, k);
     }
 }
 
@@ -16,6 +16,10 @@ filelink_command::filelink_command(lf::engine& e)
 {
     get_arguments().push_back(credentials::get_arguments());
     get_arguments().push_back(s_report_level_arg);
+    get_arguments().push_back(s_timings_arg);
+    get_arguments().push_back(s_http_arg);
+    get_arguments().push_back(s_upload_buffer_arg);
+    get_arguments().push_back(s_upload_limit_arg);
     get_arguments().push_back(m_expire_argument);
     get_arguments().push_back(s_attachment_argument);
     get_arguments().push_back(m_file_argument);
@@ -23,6 +27,8 @@ filelink_command::filelink_command(lf::engine& e)
 
 void filelink_command::execute(const cmd::arguments& args)
 {
+    timings t(args);
+    m_engine.set_http_version(s_http_arg.value(args));
     credentials c = credentials::manage(args);
     lf::report_level rl = s_report_level_arg.value(args);
     std::string expire = m_expire_argument.value(args);
@@ -31,6 +37,8 @@ void filelink_command::execute(const cmd::arguments& args)
         throw cmd::invalid_arguments("Need to specify only one file.");
     }
     bool r = s_attachment_argument.value(args);
+    m_engine.set_upload_buffer_size(upload_buffer_value(args));
+    set_rate_limits(args);
     if (r) {
         m_engine.filelink_attachment(c.server(), c.api_key(), expire, *unnamed_args.begin(),
                 rl, c.validate_flag());
@@ -15,12 +15,16 @@ filelinks_command::filelinks_command(lf::engine& e)
 {
     get_arguments().push_back(credentials::get_arguments());
     get_arguments().push_back(s_report_level_arg);
+    get_arguments().push_back(s_timings_arg);
+    get_arguments().push_back(s_http_arg);
     get_arguments().push_back(s_output_format_arg);
     get_arguments().push_back(m_limit_argument);
 }
 
 void filelinks_command::execute(const cmd::arguments& args)
 {
+    timings t(args);
+    m_engine.set_http_version(s_http_arg.value(args));
     credentials c = credentials::manage(args);
     lf::report_level rl = s_report_level_arg.value(args);
     lf::output_format of = s_output_format_arg.value(args);
@@ -24,10 +24,14 @@ get_api_key_command::get_api_key_command(lf::engine& e)
     get_arguments().push_back(m_password_argument);
     get_arguments().push_back(m_save_argument);
     get_arguments().push_back(s_report_level_arg);
+    get_arguments().push_back(s_timings_arg);
+    get_arguments().push_back(s_http_arg);
 }
 
 void get_api_key_command::execute(const cmd::arguments& args)
 {
+    timings t(args);
+    m_engine.set_http_version(s_http_arg.value(args));
     std::string server = m_server_argument.value(args);
     std::string user = m_username_argument.value(args);
     std::string password = m_password_argument.value(args);
@@ -17,6 +17,8 @@ messages_command::messages_command(lf::engine& e)
 {
     get_arguments().push_back(credentials::get_arguments());
     get_arguments().push_back(s_report_level_arg);
+    get_arguments().push_back(s_timings_arg);
+    get_arguments().push_back(s_http_arg);
     get_arguments().push_back(s_output_format_arg);
     get_arguments().push_back(m_message_id_argument);
     get_arguments().push_back(m_sent_in_last_argument);
@@ -25,6 +27,8 @@ messages_command::messages_command(lf::engine& e)
 
 void messages_command::execute(const cmd::arguments& args)
 {
+    timings t(args);
+    m_engine.set_http_version(s_http_arg.value(args));
     credentials c = credentials::manage(args);
     std::string l = m_sent_in_last_argument.value(args);
     std::string f = m_sent_after_argument.value(args);
@@ -14,10 +14,18 @@ send_command::send_command(lf::engine& e)
     , m_to_argument("to", "<username>", "User name or email, to send file.")
     , m_message_argument("message", "<string>", "Message text of composed email.", "")
     , m_subject_argument("subject", "<string>", "Subject of composed email.", "")
-    , m_files_argument("<file> ...", "File path(s) or attachments IDs to send to user.")
+    , m_files_argument("<file> ...", "File or directory path(s) or attachments IDs to send to user.")
 {
     get_arguments().push_back(credentials::get_arguments());
     get_arguments().push_back(s_report_level_arg);
+    get_arguments().push_back(s_timings_arg);
+    get_arguments().push_back(s_http_arg);
+    get_arguments().push_back(s_parallel_arg);
+    get_arguments().push_back(s_chunk_size_arg);
+    get_arguments().push_back(s_upload_buffer_arg);
+    get_arguments().push_back(s_upload_limit_arg);
+    get_arguments().push_back(s_include_arg);
+    get_arguments().push_back(s_exclude_arg);
     get_arguments().push_back(m_to_argument);
     get_arguments().push_back(m_subject_argument);
     get_arguments().push_back(m_message_argument);
@@ -27,6 +35,8 @@ send_command::send_command(lf::engine& e)
 
 void send_command::execute(const cmd::arguments& args)
 {
+    timings t(args);
+    m_engine.set_http_version(s_http_arg.value(args));
     credentials c = credentials::manage(args);
     std::string user = m_to_argument.value(args);
     lf::report_level rl = s_report_level_arg.value(args);
@@ -34,12 +44,17 @@ void send_command::execute(const cmd::arguments& args)
     std::string message = m_message_argument.value(args);
     std::set<std::string> unnamed_args = m_files_argument.value(args);
     bool r = s_attachment_argument.value(args);
+    unsigned p = parallel_value(args);
+    long long cs = chunk_size_value(args);
+    m_engine.set_upload_buffer_size(upload_buffer_value(args));
+    set_rate_limits(args);
+    set_file_patterns(m_engine, args);
     if (r) {
         m_engine.send_attachments(c.server(), c.api_key(), user, subject, message, unnamed_args,
                 rl, c.validate_flag());
     } else {
         m_engine.send(c.server(), c.api_key(), user, subject, message, unnamed_args,
-                rl, c.validate_flag());
+                p, cs, rl, c.validate_flag());
     }
 }
 
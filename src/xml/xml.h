@@ -1,6 +1,7 @@
 #pragma once
 
 #include "exceptions.h"
+#include "xml_scan.h"
 
 #include <cstdlib>
 #include <cassert>
@@ -9,6 +10,8 @@
 
 #define XML_STATIC_POOL_SIZE (64 * 1024)
 #define XML_DYNAMIC_POOL_SIZE (64 * 1024)
+#define XML_MAX_DYNAMIC_POOL_SIZE (2 * 1024 * 1024)
+#define XML_KEPT_POOL_SIZE (8 * 1024 * 1024)
 #define XML_ALIGNMENT sizeof(void *)
 
 namespace xml
@@ -186,6 +189,30 @@ namespace internal
         static const unsigned char lookup_upcase[256];                  // To uppercase conversion table for ASCII characters
     };
 
+    // Skip whitespace by SIMD kernels, other character types are left to the predicates
+    template<class Ch>
+    inline Ch *scan_whitespace(Ch *p)
+    {
+        return p;
+    }
+
+    inline char *scan_whitespace(char *p)
+    {
+        return const_cast<char *>(scan::skip_whitespace(p));
+    }
+
+    // Find the first of two characters or zero by SIMD kernels, other character types are left to the predicates
+    template<class Ch>
+    inline Ch *scan_to(Ch *p, char a, char b)
+    {
+        return p;
+    }
+
+    inline char *scan_to(char *p, char a, char b)
+    {
+        return const_cast<char *>(scan::find(p, a, b, b, b));
+    }
+
     // Find length of the string
     template<class Ch>
     inline std::size_t measure(const Ch *p)
@@ -241,8 +268,14 @@ namespace internal
 //! <br><br>
 //! Pool maintains <code>XML_STATIC_POOL_SIZE</code> bytes of statically allocated memory.
 //! Until static memory is exhausted, no dynamic memory allocations are done.
-//! When static memory is exhausted, pool allocates additional blocks of memory of size <code>XML_DYNAMIC_POOL_SIZE</code> each,
+//! When static memory is exhausted, pool allocates additional blocks of memory,
 //! by using global <code>new[]</code> and <code>delete[]</code> operators.
+//! The first block is <code>XML_DYNAMIC_POOL_SIZE</code> bytes, every next one is twice as large,
+//! up to <code>XML_MAX_DYNAMIC_POOL_SIZE</code> bytes.
+//! <br><br>
+//! Pool, which is used for many parses, can be reset() instead of clear().
+//! Reset keeps the largest blocks, up to <code>XML_KEPT_POOL_SIZE</code> bytes in total, and allocates from them again,
+//! so the next parses of similar documents do not allocate memory.
 //! This behaviour can be changed by setting custom allocation routines.
 //! Use set_allocator() function to set them.
 //! <br><br>
@@ -269,7 +302,8 @@ public:
 
     //! Constructs empty pool with default allocator functions.
     memory_pool()
-        : m_alloc_func(0)
+        : m_spare(0)
+        , m_alloc_func(0)
         , m_free_func(0)
     {
         init();
@@ -402,12 +436,49 @@ public:
         while (m_begin != m_static_memory)
         {
             char *previous_begin = reinterpret_cast<header *>(align(m_begin))->previous_begin;
-            if (m_free_func)
-                m_free_func(m_begin);
-            else
-                delete[] m_begin;
+            free_raw(m_begin);
+            m_begin = previous_begin;
+        }
+        while (m_spare)
+        {
+            char *next = reinterpret_cast<header *>(align(m_spare))->previous_begin;
+            free_raw(m_spare);
+            m_spare = next;
+        }
+        init();
+    }
+
+    //! Clears the pool, but keeps the largest blocks of dynamic memory to allocate from them again.
+    //! Blocks are kept up to <code>XML_KEPT_POOL_SIZE</code> bytes in total, the rest is freed.
+    //! Any nodes or strings allocated from the pool will no longer be valid.
+    void reset()
+    {
+        // Spare blocks are listed from the largest one
+        while (m_begin != m_static_memory)
+        {
+            header *h = reinterpret_cast<header *>(align(m_begin));
+            char *previous_begin = h->previous_begin;
+            char **next = &m_spare;
+            while (*next && reinterpret_cast<header *>(align(*next))->size >= h->size)
+                next = &reinterpret_cast<header *>(align(*next))->previous_begin;
+            h->previous_begin = *next;
+            *next = m_begin;
             m_begin = previous_begin;
         }
+        std::size_t kept = 0;
+        for (char **next = &m_spare; *next; )
+        {
+            header *h = reinterpret_cast<header *>(align(*next));
+            if (kept + h->size <= XML_KEPT_POOL_SIZE)
+            {
+                kept += h->size;
+                next = &h->previous_begin;
+                continue;
+            }
+            char *block = *next;
+            *next = h->previous_begin;
+            free_raw(block);
+        }
         init();
     }
 
@@ -426,7 +497,7 @@ public:
     //! \param ff Free function, or 0 to restore default function
     void set_allocator(alloc_func *af, free_func *ff)
     {
-        assert(m_begin == m_static_memory && m_ptr == align(m_begin));    // Verify that no memory is allocated yet
+        assert(m_begin == m_static_memory && m_ptr == align(m_begin) && !m_spare);    // Verify that no memory is allocated yet
         m_alloc_func = af;
         m_free_func = ff;
     }
@@ -435,7 +506,8 @@ private:
 
     struct header
     {
-        char *previous_begin;
+        char *previous_begin;       // Start of previous pool, or of next spare block
+        std::size_t size;           // Size of raw memory
     };
 
     void init()
@@ -443,6 +515,7 @@ private:
         m_begin = m_static_memory;
         m_ptr = align(m_begin);
         m_end = m_static_memory + sizeof(m_static_memory);
+        m_dynamic_size = XML_DYNAMIC_POOL_SIZE;
     }
 
     char *align(char *ptr)
@@ -467,6 +540,14 @@ private:
         return static_cast<char *>(memory);
     }
 
+    void free_raw(char *raw)
+    {
+        if (m_free_func)
+            m_free_func(raw);
+        else
+            delete[] raw;
+    }
+
     void *allocate_aligned(std::size_t size)
     {
         // Calculate aligned pointer
@@ -475,19 +556,30 @@ private:
         // If not enough memory left in current pool, allocate a new pool
         if (result + size > m_end)
         {
-            // Calculate required pool size (may be bigger than XML_DYNAMIC_POOL_SIZE)
-            std::size_t pool_size = XML_DYNAMIC_POOL_SIZE;
+            // Calculate required pool size (may be bigger than current dynamic pool size)
+            std::size_t pool_size = m_dynamic_size;
             if (pool_size < size)
                 pool_size = size;
+            if (m_dynamic_size < XML_MAX_DYNAMIC_POOL_SIZE)
+                m_dynamic_size *= 2;
 
-            // Allocate
+            // Take the largest spare block, if it is large enough, or allocate
             std::size_t alloc_size = sizeof(header) + (2 * XML_ALIGNMENT - 2) + pool_size;     // 2 alignments required in worst case: one for header, one for actual allocation
-            char *raw_memory = allocate_raw(alloc_size);
+            char *raw_memory = m_spare;
+            if (raw_memory && reinterpret_cast<header *>(align(raw_memory))->size >= alloc_size)
+            {
+                header *spare = reinterpret_cast<header *>(align(raw_memory));
+                m_spare = spare->previous_begin;
+                alloc_size = spare->size;
+            }
+            else
+                raw_memory = allocate_raw(alloc_size);
 
             // Setup new pool in allocated memory
             char *pool = align(raw_memory);
             header *new_header = reinterpret_cast<header *>(pool);
             new_header->previous_begin = m_begin;
+            new_header->size = alloc_size;
             m_begin = raw_memory;
             m_ptr = pool + sizeof(header);
             m_end = raw_memory + alloc_size;
@@ -504,6 +596,8 @@ private:
     char *m_begin;                                      // Start of raw memory making up current pool
     char *m_ptr;                                        // First free byte in current pool
     char *m_end;                                        // One past last available byte in current pool
+    char *m_spare;                                      // Largest of blocks kept by reset, or 0 if there are none
+    std::size_t m_dynamic_size;                         // Size of next dynamic pool
     char m_static_memory[XML_STATIC_POOL_SIZE];    // Static raw memory
     alloc_func *m_alloc_func;                           // Allocator function, or 0 if default is to be used
     free_func *m_free_func;                             // Free function, or 0 if default is to be used
@@ -1290,6 +1384,15 @@ public:
         memory_pool<Ch>::clear();
     }
 
+    //! Clears the document by deleting all nodes, but keeps the largest blocks of memory pool to parse into again.
+    //! All nodes owned by document pool are destroyed.
+    void reset()
+    {
+        this->remove_all_nodes();
+        this->remove_all_attributes();
+        memory_pool<Ch>::reset();
+    }
+
 private:
 
     ///////////////////////////////////////////////////////////////////////
@@ -1298,6 +1401,11 @@ private:
     // Detect whitespace character
     struct whitespace_pred
     {
+        static Ch *scan(Ch *text)
+        {
+            return internal::scan_whitespace(text);
+        }
+
         static unsigned char test(Ch ch)
         {
             return internal::lookup_tables<0>::lookup_whitespace[static_cast<unsigned char>(ch)];
@@ -1307,6 +1415,11 @@ private:
     // Detect node name character
     struct node_name_pred
     {
+        static Ch *scan(Ch *text)
+        {
+            return text;
+        }
+
         static unsigned char test(Ch ch)
         {
             return internal::lookup_tables<0>::lookup_node_name[static_cast<unsigned char>(ch)];
@@ -1316,6 +1429,11 @@ private:
     // Detect attribute name character
     struct attribute_name_pred
     {
+        static Ch *scan(Ch *text)
+        {
+            return text;
+        }
+
         static unsigned char test(Ch ch)
         {
             return internal::lookup_tables<0>::lookup_attribute_name[static_cast<unsigned char>(ch)];
@@ -1325,6 +1443,11 @@ private:
     // Detect text character (PCDATA)
     struct text_pred
     {
+        static Ch *scan(Ch *text)
+        {
+            return internal::scan_to(text, '<', '<');
+        }
+
         static unsigned char test(Ch ch)
         {
             return internal::lookup_tables<0>::lookup_text[static_cast<unsigned char>(ch)];
@@ -1334,6 +1457,11 @@ private:
     // Detect text character (PCDATA) that does not require processing
     struct text_pure_no_ws_pred
     {
+        static Ch *scan(Ch *text)
+        {
+            return internal::scan_to(text, '<', '&');
+        }
+
         static unsigned char test(Ch ch)
         {
             return internal::lookup_tables<0>::lookup_text_pure_no_ws[static_cast<unsigned char>(ch)];
@@ -1343,6 +1471,11 @@ private:
     // Detect text character (PCDATA) that does not require processing
     struct text_pure_with_ws_pred
     {
+        static Ch *scan(Ch *text)
+        {
+            return text;
+        }
+
         static unsigned char test(Ch ch)
         {
             return internal::lookup_tables<0>::lookup_text_pure_with_ws[static_cast<unsigned char>(ch)];
@@ -1353,6 +1486,11 @@ private:
     template<Ch Quote>
     struct attribute_value_pred
     {
+        static Ch *scan(Ch *text)
+        {
+            return internal::scan_to(text, static_cast<char>(Quote), static_cast<char>(Quote));
+        }
+
         static unsigned char test(Ch ch)
         {
             if (Quote == Ch('\''))
@@ -1367,6 +1505,11 @@ private:
     template<Ch Quote>
     struct attribute_value_pure_pred
     {
+        static Ch *scan(Ch *text)
+        {
+            return internal::scan_to(text, static_cast<char>(Quote), '&');
+        }
+
         static unsigned char test(Ch ch)
         {
             if (Quote == Ch('\''))
@@ -1425,10 +1568,11 @@ private:
     }
 
     // Skip characters until predicate evaluates to true
+    // Predicates of long runs scan to the stop character by SIMD first
     template<class StopPred, int Flags>
     static void skip(Ch *&text)
     {
-        Ch *tmp = text;
+        Ch *tmp = StopPred::scan(text);
         while (StopPred::test(*tmp))
             ++tmp;
         text = tmp;
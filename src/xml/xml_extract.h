@@ -0,0 +1,145 @@
+#pragma once
+
+#include "xml_scan.h"
+
+#include <cstddef>
+#include <cstring>
+
+namespace xml
+{
+
+//! Name of element, which is matched by comparison of constant characters,
+//! so no name string is built or measured. Names are up to 12 characters,
+//! for example tag<'i', 'd'>.
+template<char C0, char C1 = 0, char C2 = 0, char C3 = 0, char C4 = 0, char C5 = 0,
+         char C6 = 0, char C7 = 0, char C8 = 0, char C9 = 0, char C10 = 0, char C11 = 0>
+struct tag
+{
+    enum
+    {
+        size = (C0 != 0) + (C1 != 0) + (C2 != 0) + (C3 != 0) + (C4 != 0) + (C5 != 0)
+            + (C6 != 0) + (C7 != 0) + (C8 != 0) + (C9 != 0) + (C10 != 0) + (C11 != 0)
+    };
+
+    //! Checks whether the name of given size is this one.
+    static bool match(const char *name, std::size_t n)
+    {
+        return n == static_cast<std::size_t>(size)
+            && (size < 1 || name[0] == C0) && (size < 2 || name[1] == C1)
+            && (size < 3 || name[2] == C2) && (size < 4 || name[3] == C3)
+            && (size < 5 || name[4] == C4) && (size < 6 || name[5] == C5)
+            && (size < 7 || name[6] == C6) && (size < 8 || name[7] == C7)
+            && (size < 9 || name[8] == C8) && (size < 10 || name[9] == C9)
+            && (size < 11 || name[10] == C10) && (size < 12 || name[11] == C11);
+    }
+};
+
+//! Result of extract().
+enum extract_result
+{
+    extract_found,      //!< Field is found, its value is given
+    extract_error,      //!< Root is <error>, value of its <message> is given if there is one
+    extract_missing     //!< Field is not found or the document ends too early
+};
+
+//! \cond internal
+namespace internal
+{
+
+    typedef tag<'e', 'r', 'r', 'o', 'r'> error_tag;
+    typedef tag<'m', 'e', 's', 's', 'a', 'g', 'e'> message_tag;
+
+    // Find the end of name, which begins at p
+    inline const char *name_end(const char *p)
+    {
+        while (*p != 0 && *p != '>' && *p != '/' && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+            ++p;
+        return p;
+    }
+
+    // Find the '>' of tag, which is not inside a quoted attribute value, or the terminating zero
+    inline const char *tag_end(const char *p)
+    {
+        while (true)
+        {
+            p = scan::find(p, '>', '"', '\'', '>');
+            if (*p != '"' && *p != '\'')
+                return p;
+            p = scan::find(p + 1, *p, *p, *p, *p);
+            if (*p == 0)
+                return p;
+            ++p;
+        }
+    }
+
+    // Find the position after the end marker of comment, CDATA, declaration or processing instruction at p
+    inline const char *markup_end(const char *p)
+    {
+        const char *e = p[1] == '?' ? "?>"
+            : std::strncmp(p, "<!--", 4) == 0 ? "-->"
+            : std::strncmp(p, "<![CDATA[", 9) == 0 ? "]]>" : ">";
+        p = std::strstr(p + 2, e);
+        return p == 0 ? 0 : p + std::strlen(e);
+    }
+
+}
+//! \endcond
+
+//! Finds the value of child element of root, which is named by Field, in zero terminated text.
+//! The text is scanned once without building nodes, and the scan stops at the first match.
+//! If the root is <error>, value of its <message> child is given instead.
+//! Value is the text up to the first markup inside the element, entities are not translated.
+//! \param text XML data.
+//! \param value Set to the beginning of value, which is not zero terminated.
+//! \param size Set to the size of value.
+//! \return Whether the field or an error is found.
+template<class Field>
+extract_result extract(const char *text, const char *&value, std::size_t &size)
+{
+    value = 0;
+    size = 0;
+    bool error = false;
+    int depth = 0;
+    for (const char *p = scan::find(text, '<', '<', '<', '<'); *p != 0; p = scan::find(p, '<', '<', '<', '<'))
+    {
+        if (p[1] == '?' || p[1] == '!')
+        {
+            p = internal::markup_end(p);
+            if (p == 0)
+                break;
+            continue;
+        }
+        const char *end = internal::tag_end(p + 1);
+        if (*end == 0)
+            break;
+        if (p[1] == '/')
+        {
+            if (--depth <= 0)
+                break;
+            p = end + 1;
+            continue;
+        }
+        const char *name = p + 1;
+        std::size_t n = internal::name_end(name) - name;
+        bool empty = end[-1] == '/';
+        if (depth == 0)
+            error = internal::error_tag::match(name, n);
+        else if (depth == 1 && (error ? internal::message_tag::match(name, n) : Field::match(name, n)))
+        {
+            const char *last = empty ? end + 1 : scan::find(end + 1, '<', '<', '<', '<');
+            if (*last == 0 && !empty)
+                break;
+            value = end + 1;
+            size = last - value;
+            return error ? extract_error : extract_found;
+        }
+        if (!empty)
+            ++depth;
+        else if (depth == 0)
+            break;
+        p = end + 1;
+    }
+    return error ? extract_error : extract_missing;
+}
+
+}
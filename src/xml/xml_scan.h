@@ -0,0 +1,248 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define XML_SCAN_SIMD 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+namespace xml
+{
+
+/**
+ * @brief Kernels, which scan zero terminated text for the parser.
+ *
+ *        SIMD kernels compare 16 or 32 bytes at once. They read by aligned
+ *        blocks, so they never cross a page beyond the terminating zero,
+ *        but may read a few bytes after it within the same block.
+ *        The kernel is picked by the processor on the first use.
+ */
+namespace scan
+{
+
+enum kernel
+{
+    kernel_scalar,
+    kernel_sse2,
+    kernel_avx2
+};
+
+namespace internal
+{
+
+    typedef const char* (*find_function)(const char* p, char a, char b, char c, char d);
+    typedef const char* (*skip_function)(const char* p);
+
+    inline bool is_whitespace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    inline const char* find_scalar(const char* p, char a, char b, char c, char d)
+    {
+        while (*p != a && *p != b && *p != c && *p != d && *p != 0)
+            ++p;
+        return p;
+    }
+
+    inline const char* skip_whitespace_scalar(const char* p)
+    {
+        while (is_whitespace(*p))
+            ++p;
+        return p;
+    }
+
+#ifdef XML_SCAN_SIMD
+
+    __attribute__((target("sse2")))
+    inline unsigned find_mask_sse2(const __m128i* q, char a, char b, char c, char d)
+    {
+        __m128i x = _mm_load_si128(q);
+        __m128i m = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(a)), _mm_cmpeq_epi8(x, _mm_set1_epi8(b))),
+                _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(c)), _mm_cmpeq_epi8(x, _mm_set1_epi8(d))));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_setzero_si128()));
+        return static_cast<unsigned>(_mm_movemask_epi8(m));
+    }
+
+    __attribute__((target("sse2")))
+    inline unsigned space_mask_sse2(const __m128i* q)
+    {
+        __m128i x = _mm_load_si128(q);
+        __m128i m = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(x, _mm_set1_epi8('\t'))),
+                _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(x, _mm_set1_epi8('\r'))));
+        return ~static_cast<unsigned>(_mm_movemask_epi8(m)) & 0xffff;
+    }
+
+    __attribute__((target("sse2")))
+    inline const char* find_sse2(const char* p, char a, char b, char c, char d)
+    {
+        std::size_t o = reinterpret_cast<std::size_t>(p) & 15;
+        const __m128i* q = reinterpret_cast<const __m128i*>(p - o);
+        unsigned m = find_mask_sse2(q, a, b, c, d) >> o;
+        if (m != 0)
+            return p + __builtin_ctz(m);
+        while ((m = find_mask_sse2(++q, a, b, c, d)) == 0)
+            ;
+        return reinterpret_cast<const char*>(q) + __builtin_ctz(m);
+    }
+
+    __attribute__((target("sse2")))
+    inline const char* skip_whitespace_sse2(const char* p)
+    {
+        std::size_t o = reinterpret_cast<std::size_t>(p) & 15;
+        const __m128i* q = reinterpret_cast<const __m128i*>(p - o);
+        unsigned m = space_mask_sse2(q) >> o;
+        if (m != 0)
+            return p + __builtin_ctz(m);
+        while ((m = space_mask_sse2(++q)) == 0)
+            ;
+        return reinterpret_cast<const char*>(q) + __builtin_ctz(m);
+    }
+
+    __attribute__((target("avx2")))
+    inline unsigned find_mask_avx2(const __m256i* q, char a, char b, char c, char d)
+    {
+        __m256i x = _mm256_load_si256(q);
+        __m256i m = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(a)), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(b))),
+                _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(c)), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(d))));
+        m = _mm256_or_si256(m, _mm256_cmpeq_epi8(x, _mm256_setzero_si256()));
+        return static_cast<unsigned>(_mm256_movemask_epi8(m));
+    }
+
+    __attribute__((target("avx2")))
+    inline unsigned space_mask_avx2(const __m256i* q)
+    {
+        __m256i x = _mm256_load_si256(q);
+        __m256i m = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\t'))),
+                _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\r'))));
+        return ~static_cast<unsigned>(_mm256_movemask_epi8(m));
+    }
+
+    __attribute__((target("avx2")))
+    inline const char* find_avx2(const char* p, char a, char b, char c, char d)
+    {
+        std::size_t o = reinterpret_cast<std::size_t>(p) & 31;
+        const __m256i* q = reinterpret_cast<const __m256i*>(p - o);
+        unsigned m = find_mask_avx2(q, a, b, c, d) >> o;
+        if (m != 0)
+            return p + __builtin_ctz(m);
+        while ((m = find_mask_avx2(++q, a, b, c, d)) == 0)
+            ;
+        return reinterpret_cast<const char*>(q) + __builtin_ctz(m);
+    }
+
+    __attribute__((target("avx2")))
+    inline const char* skip_whitespace_avx2(const char* p)
+    {
+        std::size_t o = reinterpret_cast<std::size_t>(p) & 31;
+        const __m256i* q = reinterpret_cast<const __m256i*>(p - o);
+        unsigned m = space_mask_avx2(q) >> o;
+        if (m != 0)
+            return p + __builtin_ctz(m);
+        while ((m = space_mask_avx2(++q)) == 0)
+            ;
+        return reinterpret_cast<const char*>(q) + __builtin_ctz(m);
+    }
+
+#endif
+
+    inline bool supported(kernel k)
+    {
+#ifdef XML_SCAN_SIMD
+        __builtin_cpu_init();
+        if (k == kernel_avx2)
+            return __builtin_cpu_supports("avx2");
+        if (k == kernel_sse2)
+            return __builtin_cpu_supports("sse2");
+#endif
+        return k == kernel_scalar;
+    }
+
+    // Kernels in use
+    struct kernels
+    {
+        kernels()
+        {
+            set(supported(kernel_avx2) ? kernel_avx2
+                    : supported(kernel_sse2) ? kernel_sse2 : kernel_scalar);
+        }
+
+        void set(kernel k)
+        {
+            m_kernel = k;
+            m_find = &find_scalar;
+            m_skip_whitespace = &skip_whitespace_scalar;
+#ifdef XML_SCAN_SIMD
+            if (k == kernel_avx2)
+            {
+                m_find = &find_avx2;
+                m_skip_whitespace = &skip_whitespace_avx2;
+            }
+            else if (k == kernel_sse2)
+            {
+                m_find = &find_sse2;
+                m_skip_whitespace = &skip_whitespace_sse2;
+            }
+#endif
+        }
+
+        kernel m_kernel;
+        find_function m_find;
+        skip_function m_skip_whitespace;
+    };
+
+    inline kernels& get()
+    {
+        static kernels k;
+        return k;
+    }
+
+}
+
+//! Gets the kernel in use.
+inline kernel current()
+{
+    return internal::get().m_kernel;
+}
+
+//! Checks whether the processor supports the kernel.
+inline bool supported(kernel k)
+{
+    return internal::supported(k);
+}
+
+//! Sets the kernel to use, it must be supported. Not thread safe, meant
+//! for benchmarks and tests.
+inline void use(kernel k)
+{
+    internal::get().set(k);
+}
+
+//! Finds the first of the given characters or the terminating zero.
+//! Repeat a character to look for less than four.
+inline const char* find(const char* p, char a, char b, char c, char d)
+{
+    // Most of scanned runs are short, so the first character is checked
+    // before the call of kernel.
+    if (*p == a || *p == b || *p == c || *p == d || *p == 0)
+        return p;
+    return internal::get().m_find(p, a, b, c, d);
+}
+
+//! Finds the first character, which is not whitespace.
+inline const char* skip_whitespace(const char* p)
+{
+    if (!internal::is_whitespace(*p))
+        return p;
+    return internal::get().m_skip_whitespace(p);
+}
+
+}
+
+}
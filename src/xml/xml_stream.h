@@ -0,0 +1,302 @@
+#pragma once
+
+#include "xml.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace xml
+{
+
+/**
+ * @class element_handler
+ * @brief Receives the elements, which are read by stream_parser.
+ */
+class element_handler
+{
+public:
+    virtual ~element_handler()
+    {
+    }
+
+    /**
+     * @brief Handles the read element.
+     * @param n Node of element, it is valid only during the call.
+     */
+    virtual void element(node<>* n) = 0;
+
+    /// @brief Called when the elements of fed data are handled.
+    virtual void flush()
+    {
+    }
+};
+
+/**
+ * @class stream_parser
+ * @brief Incremental parser of documents, which are lists of records.
+ *
+ *        Data is fed as it comes. Every child element of root with the
+ *        given name is parsed, as soon as it is closed, and is passed to
+ *        the handler. Only the data of current element is kept, so the
+ *        memory does not grow with the size of document.
+ *        Errors are kept to be thrown by finish, so the parser can be fed
+ *        from a C callback.
+ */
+class stream_parser
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param name Name of elements to read.
+     * @param h Handler of elements.
+     */
+    stream_parser(const std::string& name, element_handler& h)
+        : m_name(name)
+        , m_handler(h)
+        , m_position(0)
+        , m_begin(std::string::npos)
+        , m_depth(0)
+        , m_size(0)
+        , m_count(0)
+        , m_error(0)
+    {
+    }
+
+    /// @brief Destructor.
+    ~stream_parser()
+    {
+        delete m_error;
+    }
+
+private:
+    stream_parser(const stream_parser&);
+    stream_parser& operator=(const stream_parser&);
+
+public:
+    /**
+     * @brief Parses the next part of document.
+     * @param d Data.
+     * @param n Size of data.
+     * @return False if the document is not valid.
+     */
+    bool feed(const char* d, std::size_t n)
+    {
+        if (failed()) {
+            return false;
+        }
+        m_size += n;
+        m_buffer.append(d, n);
+        try {
+            while (scan()) {
+            }
+        } catch (const parse_error& e) {
+            m_error = new parse_error(e);
+            return false;
+        }
+        m_handler.flush();
+        std::string::size_type k = m_begin == std::string::npos ? m_position : m_begin;
+        m_buffer.erase(0, k);
+        m_position -= k;
+        if (m_begin != std::string::npos) {
+            m_begin = 0;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Checks the end of document.
+     * @throw parse_error.
+     */
+    void finish()
+    {
+        if (!failed() && m_depth != 0) {
+            fail("unexpected end of data", m_position);
+        }
+        if (failed()) {
+            throw *m_error;
+        }
+    }
+
+    /// @brief Checks whether the document was found not valid.
+    bool failed() const
+    {
+        return m_error != 0;
+    }
+
+    /// @brief Gets the count of bytes fed.
+    long long size() const
+    {
+        return m_size;
+    }
+
+    /// @brief Gets the count of elements passed to handler.
+    unsigned long count() const
+    {
+        return m_count;
+    }
+
+    /// @brief Forgets the fed data, to parse the document again.
+    void reset()
+    {
+        m_buffer.clear();
+        m_position = 0;
+        m_begin = std::string::npos;
+        m_depth = 0;
+        m_size = 0;
+        m_count = 0;
+        delete m_error;
+        m_error = 0;
+    }
+
+private:
+    /// Processes the markup at current position, false if it is incomplete.
+    bool scan()
+    {
+        std::string::size_type i = m_buffer.find('<', m_position);
+        if (m_depth == 0) {
+            std::string::size_type t = m_buffer.find_first_not_of(" \t\r\n", m_position);
+            if (t < i) {
+                fail("expected <", t);
+            }
+        }
+        if (i == std::string::npos) {
+            m_position = m_buffer.size();
+            return false;
+        }
+        m_position = i;
+        int c = starts("<!--", i);
+        if (c != 0) {
+            return c > 0 && skip("-->", i + 4);
+        }
+        c = starts("<![CDATA[", i);
+        if (c != 0) {
+            return c > 0 && skip("]]>", i + 9);
+        }
+        c = starts("<?", i);
+        if (c != 0) {
+            return c > 0 && skip("?>", i + 2);
+        }
+        c = starts("<!", i);
+        if (c != 0) {
+            return c > 0 && skip(">", i + 2);
+        }
+        c = starts("</", i);
+        if (c < 0) {
+            return false;
+        }
+        std::string::size_type e = tag_end(i + 1);
+        if (e == std::string::npos) {
+            return false;
+        }
+        m_position = e + 1;
+        if (c > 0) {
+            if (--m_depth < 0) {
+                fail("unexpected closing tag", i);
+            }
+            if (m_depth == 1 && m_begin != std::string::npos) {
+                read(m_position);
+            }
+            return true;
+        }
+        bool empty = m_buffer[e - 1] == '/';
+        if (m_depth == 1 && m_begin == std::string::npos) {
+            std::string::size_type k = m_buffer.find_first_of(" \t\r\n/>", i + 1);
+            if (m_buffer.compare(i + 1, k - i - 1, m_name) == 0) {
+                m_begin = i;
+            }
+        }
+        if (empty) {
+            if (m_depth == 1 && m_begin != std::string::npos) {
+                read(m_position);
+            }
+        } else {
+            ++m_depth;
+        }
+        return true;
+    }
+
+    /// Checks whether the markup at i begins with s, -1 if undecided yet.
+    int starts(const char* s, std::string::size_type i) const
+    {
+        std::string::size_type n = std::strlen(s);
+        std::string::size_type k = std::min(n, m_buffer.size() - i);
+        if (m_buffer.compare(i, k, s, k) != 0) {
+            return 0;
+        }
+        return k == n ? 1 : -1;
+    }
+
+    /// Moves after the end marker s, false if it is not received yet.
+    bool skip(const char* s, std::string::size_type i)
+    {
+        std::string::size_type e = m_buffer.find(s, i);
+        if (e == std::string::npos) {
+            return false;
+        }
+        m_position = e + std::strlen(s);
+        return true;
+    }
+
+    /// Finds the end of tag, which is not inside a quoted attribute value.
+    std::string::size_type tag_end(std::string::size_type i) const
+    {
+        const char* b = m_buffer.c_str();
+        const char* e = b + m_buffer.size();
+        for (const char* p = b + i; p < e; ++p) {
+            p = scan::find(p, '>', '"', '\'', '>');
+            if (p < e && *p == '>') {
+                return p - b;
+            }
+            if (p < e && *p != 0) {
+                char q = *p;
+                do {
+                    p = scan::find(p + 1, q, q, q, q);
+                } while (p < e && *p != q);
+            }
+        }
+        return std::string::npos;
+    }
+
+    /**
+     * Parses the element, which ends at e, and passes it to handler.
+     * Non destructive parsing does not change the buffer, so the element is
+     * parsed in place, only the end of it is terminated for a while. The
+     * document is reused, so its memory is allocated for the first elements
+     * only.
+     */
+    void read(std::string::size_type e)
+    {
+        std::string::size_type b = m_begin;
+        m_begin = std::string::npos;
+        char* t = &m_buffer[0];
+        char c = t[e];
+        t[e] = 0;
+        m_document.reset();
+        m_document.parse<parse_fastest | parse_no_utf8>(t + b);
+        m_handler.element(m_document.first_node());
+        ++m_count;
+        t[e] = c;
+    }
+
+    void fail(const char* what, std::string::size_type i)
+    {
+        std::string w = m_buffer.substr(i, 10);
+        w.resize(10, ' ');
+        throw parse_error(what, w.c_str());
+    }
+
+private:
+    std::string m_name;
+    element_handler& m_handler;
+    std::string m_buffer;
+    std::string::size_type m_position;
+    std::string::size_type m_begin;
+    int m_depth;
+    long long m_size;
+    unsigned long m_count;
+    parse_error* m_error;
+    document<> m_document;
+};
+
+}
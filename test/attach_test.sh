@@ -11,7 +11,11 @@ ID2=`$EXEC attach --server=$SERVER -k --api_key=$KEY $DIR/attach_test.sh`
 test_status "Couldn't upload file"
 ID2=${ID2##* }
 
-MESSAGE=`$EXEC send --to=xustup@example.com --server=$SERVER -k -r --api_key=$KEY --message="Hello" --subject="Hello!" $ID1 $ID2`
+ID3=`$EXEC attach --server=$SERVER -k --api_key=$KEY --chunk_size=256 --parallel=2 $DIR/common.sh`
+test_status "Couldn't upload file by chunks"
+ID3=${ID3##* }
+
+MESSAGE=`$EXEC send --to=xustup@example.com --server=$SERVER -k -r --api_key=$KEY --message="Hello" --subject="Hello!" $ID1 $ID2 $ID3`
 test_status "Couldn't send message."
 MESSAGE=${MESSAGE##* }
 
@@ -25,5 +29,9 @@ if [ ! -f .tmp_test/attach_test.sh ]; then
     echo "Couldn't download file."
     fail
 fi
+if ! cmp -s .tmp_test/common.sh $DIR/common.sh; then
+    echo "File uploaded by chunks differs from original."
+    fail
+fi
 rm -rf .tmp_test
 echo "Test PASSED."
@@ -0,0 +1,46 @@
+#! /bin/bash
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+source $DIR/common.sh
+
+mkdir .tmp_test
+cat > .tmp_test/commands <<END
+# Sends two messages and lists them.
+send --to=xustup@example.com --server=$SERVER -k --api_key=$KEY --subject="Batch test" $DIR/send_test.sh
+send --to=xustup@example.com --server=$SERVER -k --api_key=$KEY --subject="Batch test" $DIR/large_file
+messages --server=$SERVER -k --api_key=$KEY --sent_in_the_last=1
+END
+
+$EXEC batch --jobs=2 .tmp_test/commands > .tmp_test/output
+test_status "Batch failed."
+if [ `grep -c "exited with status 0" .tmp_test/output` -ne 3 ]; then
+    echo "Not all commands of batch succeeded."
+    fail
+fi
+
+echo "bogus_command" | $EXEC batch
+if [ $? -eq 0 ]; then
+    echo "Batch with failed command succeeded."
+    fail
+fi
+echo "send --to=xustup@example.com --server=$SERVER -k --api_key=$KEY --upload_limit=1M $DIR/send_test.sh" | $EXEC batch --upload_limit=64K
+if [ $? -eq 0 ]; then
+    echo "Command changed bandwidth limits of batch."
+    fail
+fi
+
+echo "daemon --socket=`pwd`/.tmp_test/daemon.sock" | timeout 10 $EXEC batch
+if [ $? -ne 1 ]; then
+    echo "Batch executed daemon."
+    fail
+fi
+
+echo "bogus_b" > .tmp_test/b
+echo "bogus_a" > .tmp_test/a
+$EXEC batch .tmp_test/b .tmp_test/a .tmp_test/b > .tmp_test/output
+if [ "`grep -o 'bogus_.$' .tmp_test/output | tr '\n' ' '`" != "bogus_b bogus_a bogus_b " ]; then
+    echo "Files of batch are not read in the given order."
+    fail
+fi
+rm -rf .tmp_test
+echo "Test PASSED."
@@ -0,0 +1,30 @@
+#! /bin/bash
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+source $DIR/common.sh
+
+mkdir .tmp_test
+export LIQUIDFILES_SOCKET=`pwd`/.tmp_test/daemon.sock
+$EXEC daemon --jobs=2 --timings=.tmp_test/timings.csv &
+DAEMON=$!
+sleep 1
+
+MESSAGE=`$EXEC send --to=xustup@example.com --server=$SERVER -k --api_key=$KEY --subject="Daemon test" $DIR/send_test.sh`
+status=$?
+MESSAGE=${MESSAGE##* }
+kill $DAEMON
+unset LIQUIDFILES_SOCKET
+if [ $status -ne 0 ]; then
+    echo "Error: Couldn't send message by daemon."
+    fail
+fi
+# Client runs the command by itself, when daemon does not take it.
+if [ `grep -c ",POST,.*,200,0," .tmp_test/timings.csv` -lt 2 ]; then
+    echo "Error: Message is not sent by daemon."
+    fail
+fi
+rm -rf .tmp_test
+
+test_message $MESSAGE
+rm -rf .tmp_test
+echo "Test PASSED."
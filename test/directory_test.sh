@@ -0,0 +1,27 @@
+#! /bin/bash
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+source $DIR/common.sh
+
+mkdir -p .tmp_tree/docs/old .tmp_tree/build
+cp $DIR/send_test.sh .tmp_tree/docs/
+cp $DIR/attach_test.sh .tmp_tree/docs/old/
+cp $DIR/common.sh .tmp_tree/build/
+cp $DIR/aaa.jpg .tmp_tree/
+
+MESSAGE=`$EXEC send --to=xustup@example.com --server=$SERVER -k --api_key=$KEY --parallel=2 --include="*.sh" --exclude=build,old/* .tmp_tree`
+test_status "Couldn't send directory."
+MESSAGE=${MESSAGE##* }
+
+test_message $MESSAGE
+
+if [ ! -f .tmp_test/send_test.sh ] || [ ! -f .tmp_test/attach_test.sh ]; then
+    echo "Files of subdirectories are not sent."
+    fail
+fi
+if [ -f .tmp_test/common.sh ] || [ -f .tmp_test/aaa.jpg ]; then
+    echo "Excluded files are sent."
+    fail
+fi
+rm -rf .tmp_test .tmp_tree
+echo "Test PASSED."
@@ -0,0 +1,36 @@
+#! /bin/bash
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+source $DIR/common.sh
+
+mkdir .tmp_test
+head -c 262144 /dev/urandom > .tmp_test/limited
+
+# 256K at 64K per second takes 4 seconds.
+SECONDS=0
+MESSAGE=`$EXEC send --to=xustup@example.com --server=$SERVER -k --api_key=$KEY --subject="Rate limit test" --upload_limit=64K .tmp_test/limited`
+test_status "Couldn't send message."
+MESSAGE=${MESSAGE##* }
+if [ $SECONDS -lt 3 ]; then
+    echo "Upload was not limited."
+    fail
+fi
+
+mkdir .tmp_test/download
+SECONDS=0
+$EXEC download --server=$SERVER -k --api_key=$KEY --message_id=$MESSAGE --download_to=.tmp_test/download --download_limit=64K
+test_status "Couldn't download file."
+if [ $SECONDS -lt 3 ]; then
+    echo "Download was not limited."
+    fail
+fi
+cmp .tmp_test/limited .tmp_test/download/limited
+test_status "Downloaded file differs."
+
+$EXEC send --to=xustup@example.com --server=$SERVER -k --api_key=$KEY --upload_limit=25:00-08:00=1M .tmp_test/limited
+if [ $? -eq 0 ]; then
+    echo "Invalid limit is accepted."
+    fail
+fi
+rm -rf .tmp_test
+echo "Test PASSED."
@@ -0,0 +1,23 @@
+#! /bin/bash
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+source $DIR/common.sh
+
+# Nothing listens on the port, so every attempt fails before it is sent.
+OUTPUT=`$EXEC filelinks --server=http://127.0.0.1:9 -k --api_key=$KEY --report_level=verbose 2>&1`
+if [ $? -eq 0 ]; then
+    echo "Request to closed port succeeded."
+    fail
+fi
+if [ `echo "$OUTPUT" | grep -c "retrying in"` -ne 4 ]; then
+    echo "Failed request is not retried."
+    fail
+fi
+if [ `echo "$OUTPUT" | grep -c "^Requests: 5, .*, retries: 4, backoff time: [1-9]"` -ne 1 ]; then
+    echo "Retries are not in statistics."
+    fail
+fi
+
+$EXEC filelinks --server=$SERVER -k --api_key=$KEY --report_level=verbose 2>&1 | grep -q "retries: 0"
+test_status "Successful request is retried."
+echo "Test PASSED."
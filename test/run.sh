@@ -5,12 +5,18 @@ DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
 tests="
     attach_chunk_test
     attach_test
+    batch_test
     credential_test
+    daemon_test
+    directory_test
     file_request_test
     filedrop_test
     filelinks_test
+    rate_limit_test
+    retry_test
     send_test
     sending_many_files
+    timings_test
     "
 
 count=0
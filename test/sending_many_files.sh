@@ -13,5 +13,17 @@ diff .tmp_test $DIR -r
 
 test_status "Files sent incorrectly."
 
+rm -rf .tmp_test
+
+MESSAGE=`$EXEC send --to=xustup@example.com --server=$SERVER -k --api_key=$KEY --parallel=4 --message="Hello" --subject="Hello!" $DIR/*`
+test_status "Couldn't send message by parallel uploads."
+MESSAGE=${MESSAGE##* }
+
+test_message $MESSAGE
+
+diff .tmp_test $DIR -r
+
+test_status "Files sent incorrectly by parallel uploads."
+
 rm -rf .tmp_test
 echo "Test PASSED."
@@ -0,0 +1,25 @@
+#! /bin/bash
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+source $DIR/common.sh
+
+mkdir .tmp_test
+$EXEC send --to=xustup@example.com --server=$SERVER -k --api_key=$KEY --subject="Timings test" --timings=.tmp_test/timings.csv $DIR/send_test.sh > /dev/null
+test_status "Couldn't send message."
+if [ "`head -1 .tmp_test/timings.csv | cut -d, -f1-4`" != "time,method,url,status" ]; then
+    echo "Timings have no CSV header."
+    fail
+fi
+if [ `grep -c ",POST,.*,200,0," .tmp_test/timings.csv` -lt 2 ]; then
+    echo "Requests of send are not in timings."
+    fail
+fi
+
+$EXEC messages --server=$SERVER -k --api_key=$KEY --sent_in_the_last=1 --timings=.tmp_test/timings.jsonl > /dev/null
+test_status "Couldn't retrieve messages."
+if [ `grep -c '^{"time":".*"method":"GET".*"ttfb_us":.*"bytes_decoded":' .tmp_test/timings.jsonl` -ne 1 ]; then
+    echo "Request of messages is not in JSON timings."
+    fail
+fi
+rm -rf .tmp_test
+echo "Test PASSED."